@@ -474,6 +474,8 @@ static void ffmpeg_cleanup(int ret)
 
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
+        if (do_benchmark_all)
+            print_filtergraph_stats(fg);
         avfilter_graph_free(&fg->graph);
         for (j = 0; j < fg->nb_inputs; j++) {
             while (av_fifo_size(fg->inputs[j]->frame_queue)) {
@@ -2197,6 +2199,10 @@ static int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame)
             }
         }
 
+        /* let a pipelined graph finish the frames it was given */
+        if (filter_pipeline && fg->graph &&
+            (ret = avfilter_graph_process_pending(fg->graph)) < 0)
+            return ret;
         ret = reap_filters(1);
         if (ret < 0 && ret != AVERROR_EOF) {
             char errbuf[128];
@@ -4063,8 +4069,10 @@ static int init_input_threads(void)
         if (f->ctx->pb ? !f->ctx->pb->seekable :
             strcmp(f->ctx->iformat->name, "lavfi"))
             f->non_blocking = 1;
-        ret = av_thread_message_queue_alloc(&f->in_thread_queue,
-                                            f->thread_queue_size, sizeof(AVPacket));
+        /* only input_thread() sends and only the main thread receives */
+        ret = av_thread_message_queue_alloc2(&f->in_thread_queue,
+                                             f->thread_queue_size, sizeof(AVPacket),
+                                             AV_THREAD_MESSAGE_QUEUE_SPSC);
         if (ret < 0)
             return ret;
 
@@ -4445,6 +4453,23 @@ static int process_input(int file_index)
                av_ts2timestr(input_files[ist->file_index]->ts_offset, &AV_TIME_BASE_Q));
     }
 
+    if (ist->thumbnail_interval) {
+        int64_t pts = pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+
+        if (!(pkt.flags & AV_PKT_FLAG_KEY))
+            goto discard_packet;
+        /* without timestamps every keyframe is passed on */
+        if (pts != AV_NOPTS_VALUE) {
+            pts = av_rescale_q(pts, ist->st->time_base, AV_TIME_BASE_Q);
+            if (ist->next_thumbnail_pts == AV_NOPTS_VALUE)
+                ist->next_thumbnail_pts = pts;
+            if (pts < ist->next_thumbnail_pts)
+                goto discard_packet;
+            ist->next_thumbnail_pts += ((pts - ist->next_thumbnail_pts) / ist->thumbnail_interval + 1) *
+                                       ist->thumbnail_interval;
+        }
+    }
+
     sub2video_heartbeat(ist, pkt.pts);
 
     process_input_packet(ist, &pkt, 0);
@@ -141,6 +141,8 @@ typedef struct OptionsContext {
     int        nb_hwaccel_output_formats;
     SpecifierOpt *autorotate;
     int        nb_autorotate;
+    SpecifierOpt *thumbnails_per_hour;
+    int        nb_thumbnails_per_hour;
 
     /* output options */
     StreamMap *stream_maps;
@@ -343,6 +345,11 @@ typedef struct InputStream {
 
     int autorotate;
 
+    /* keyframe thumbnail mode, only the first keyframe of each interval
+     * is passed on; interval and pts are in AV_TIME_BASE units */
+    int64_t thumbnail_interval;
+    int64_t next_thumbnail_pts;
+
     int fix_sub_duration;
     struct { /* previous decoded subtitle and related variables */
         int got_output;
@@ -618,6 +625,7 @@ extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern int filter_pipeline;
 extern int vstats_version;
 
 extern const AVIOInterruptCB int_cb;
@@ -653,6 +661,7 @@ int configure_output_filter(FilterGraph *fg, OutputFilter *ofilter, AVFilterInOu
 void check_filter_outputs(void);
 int ist_in_filtergraph(FilterGraph *fg, InputStream *ist);
 int filtergraph_is_simple(FilterGraph *fg);
+void print_filtergraph_stats(FilterGraph *fg);
 int init_simple_filtergraph(InputStream *ist, OutputStream *ost);
 int init_complex_filtergraph(FilterGraph *fg);
 
@@ -982,9 +982,26 @@ static int configure_input_filter(FilterGraph *fg, InputFilter *ifilter,
     }
 }
 
+void print_filtergraph_stats(FilterGraph *fg)
+{
+    char *dump, *line, *next;
+
+    if (!fg->graph || !(dump = avfilter_graph_dump(fg->graph, "stats=text")))
+        return;
+    for (line = dump; *line; line = next) {
+        next = line + strcspn(line, "\n");
+        if (*next)
+            *next++ = 0;
+        av_log(NULL, AV_LOG_INFO, "bench: filtergraph %d %s\n", fg->index, line);
+    }
+    av_free(dump);
+}
+
 static void cleanup_filtergraph(FilterGraph *fg)
 {
     int i;
+    if (do_benchmark_all)
+        print_filtergraph_stats(fg);
     for (i = 0; i < fg->nb_outputs; i++)
         fg->outputs[i]->filter = (AVFilterContext *)NULL;
     for (i = 0; i < fg->nb_inputs; i++)
@@ -1042,6 +1059,10 @@ int configure_filtergraph(FilterGraph *fg)
     } else {
         fg->graph->nb_threads = filter_complex_nbthreads;
     }
+    if (filter_pipeline)
+        fg->graph->thread_type |= AVFILTER_THREAD_PIPELINE;
+    /* the filter times are printed with the statistics */
+    fg->graph->measure_time = do_benchmark_all;
 
     if ((ret = avfilter_graph_parse2(fg->graph, graph_desc, &inputs, &outputs)) < 0)
         goto fail;
@@ -133,6 +133,7 @@ int frame_bits_per_raw_sample = 0;
 float max_error_rate  = 2.0/3;
 int filter_nbthreads = 0;
 int filter_complex_nbthreads = 0;
+int filter_pipeline = 0;
 int vstats_version = 2;
 
 
@@ -713,6 +714,32 @@ static AVCodec *choose_decoder(OptionsContext *o, AVFormatContext *s, AVStream *
         return avcodec_find_decoder(st->codecpar->codec_id);
 }
 
+/* Smallest width lowres decoding may reduce a thumbnail source to. */
+#define THUMBNAIL_MIN_WIDTH 320
+
+static void setup_thumbnail_mode(InputStream *ist, double thumbnails_per_hour)
+{
+    const AVCodecParameters *par = ist->st->codecpar;
+    int lowres = 0;
+
+    ist->thumbnail_interval = 3600.0 * AV_TIME_BASE / thumbnails_per_hour;
+    ist->next_thumbnail_pts = AV_NOPTS_VALUE;
+
+    /* Only keyframes are wanted: let the demuxer skip everything else when
+     * it can, and have the decoder skip whatever still gets through. */
+    ist->user_set_discard = FFMAX(ist->user_set_discard, AVDISCARD_NONKEY);
+    av_dict_set(&ist->decoder_opts, "skip_frame", "nokey", AV_DICT_DONT_OVERWRITE);
+    av_dict_set(&ist->decoder_opts, "skip_loop_filter", "all", AV_DICT_DONT_OVERWRITE);
+
+    if (ist->dec) {
+        while (lowres < ist->dec->max_lowres &&
+               par->width >> (lowres + 1) >= THUMBNAIL_MIN_WIDTH)
+            lowres++;
+        if (lowres)
+            av_dict_set_int(&ist->decoder_opts, "lowres", lowres, AV_DICT_DONT_OVERWRITE);
+    }
+}
+
 /* Add all the streams from the given input file to the global
  * list of input streams. */
 static void add_input_streams(OptionsContext *o, AVFormatContext *ic)
@@ -728,6 +755,7 @@ static void add_input_streams(OptionsContext *o, AVFormatContext *ic)
         char *codec_tag = NULL;
         char *next;
         char *discard_str = NULL;
+        double thumbnails_per_hour = 0;
         const AVClass *cc = avcodec_get_class();
         const AVOption *discard_opt = av_opt_find(&cc, "skip_frame", NULL, 0, 0);
 
@@ -818,6 +846,12 @@ static void add_input_streams(OptionsContext *o, AVFormatContext *ic)
             ist->top_field_first = -1;
             MATCH_PER_STREAM_OPT(top_field_first, i, ist->top_field_first, ic, st);
 
+            MATCH_PER_STREAM_OPT(thumbnails_per_hour, dbl, thumbnails_per_hour, ic, st);
+            if (thumbnails_per_hour > 0) {
+                setup_thumbnail_mode(ist, thumbnails_per_hour);
+                ic->flags |= AVFMT_FLAG_KEYFRAMES_ONLY;
+            }
+
             MATCH_PER_STREAM_OPT(hwaccels, str, hwaccel, ic, st);
             if (hwaccel) {
                 if (!strcmp(hwaccel, "none"))
@@ -3513,6 +3547,8 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_threads", HAS_ARG | OPT_INT,                   { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "filter_pipeline", OPT_BOOL | OPT_EXPERT,                      { &filter_pipeline },
+        "run the filters of a filtergraph concurrently on successive frames" },
     { "lavfi",          HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
@@ -3640,6 +3676,9 @@ const OptionDef options[] = {
     { "autorotate",       HAS_ARG | OPT_BOOL | OPT_SPEC |
                           OPT_EXPERT | OPT_INPUT,                                { .off = OFFSET(autorotate) },
         "automatically insert correct rotate filters" },
+    { "thumbnails_per_hour", OPT_VIDEO | HAS_ARG | OPT_DOUBLE | OPT_SPEC |
+                          OPT_EXPERT | OPT_INPUT,                                { .off = OFFSET(thumbnails_per_hour) },
+        "only decode one keyframe per 1/N hour, at reduced cost", "N" },
     { "hwaccel_lax_profile_check", OPT_BOOL | OPT_EXPERT,                        { &hwaccel_lax_profile_check},
         "attempt to decode anyway if HW accelerated decoder's supported profiles do not exactly match the stream" },
 
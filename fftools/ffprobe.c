@@ -69,6 +69,8 @@ typedef struct InputStream {
     AVStream *st;
 
     AVCodecContext *dec_ctx;
+
+    int64_t next_thumbnail_ts; ///< in AV_TIME_BASE units, for -thumbnails_per_hour
 } InputStream;
 
 typedef struct InputFile {
@@ -131,6 +133,7 @@ static ReadInterval *read_intervals;
 static int read_intervals_nb = 0;
 
 static int find_stream_info  = 1;
+static double thumbnails_per_hour = 0;
 
 /* section structure definition */
 
@@ -2325,6 +2328,28 @@ static void log_read_interval(const ReadInterval *interval, void *log_ctx, int l
     av_log(log_ctx, log_level, "\n");
 }
 
+/* In thumbnail mode, only the first keyframe of each 1/N hour interval of
+ * a video stream is shown or decoded. */
+static int skip_thumbnail_packet(InputStream *ist, const AVPacket *pkt)
+{
+    int64_t interval = 3600.0 * AV_TIME_BASE / thumbnails_per_hour;
+    int64_t ts;
+
+    if (thumbnails_per_hour <= 0 ||
+        ist->st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO)
+        return 0;
+    if (!(pkt->flags & AV_PKT_FLAG_KEY) || pkt->pts == AV_NOPTS_VALUE)
+        return 1;
+
+    ts = av_rescale_q(pkt->pts, ist->st->time_base, AV_TIME_BASE_Q);
+    if (ist->next_thumbnail_ts == AV_NOPTS_VALUE)
+        ist->next_thumbnail_ts = ts;
+    if (ts < ist->next_thumbnail_ts)
+        return 1;
+    ist->next_thumbnail_ts += ((ts - ist->next_thumbnail_ts) / interval + 1) * interval;
+    return 0;
+}
+
 static int read_interval_packets(WriterContext *w, InputFile *ifile,
                                  const ReadInterval *interval, int64_t *cur_ts)
 {
@@ -2399,6 +2424,11 @@ static int read_interval_packets(WriterContext *w, InputFile *ifile,
                 break;
             }
 
+            if (skip_thumbnail_packet(&ifile->streams[pkt.stream_index], &pkt)) {
+                av_packet_unref(&pkt);
+                continue;
+            }
+
             frame_count++;
             if (do_read_packets) {
                 if (do_show_packets)
@@ -2829,6 +2859,8 @@ static int open_input_file(InputFile *ifile, const char *filename)
     }
 
     fmt_ctx->flags |= AVFMT_FLAG_KEEP_SIDE_DATA;
+    if (thumbnails_per_hour > 0)
+        fmt_ctx->flags |= AVFMT_FLAG_KEYFRAMES_ONLY;
 
     if (!av_dict_get(format_opts, "scan_all_pmts", NULL, AV_DICT_MATCH_CASE)) {
         av_dict_set(&format_opts, "scan_all_pmts", "1", AV_DICT_DONT_OVERWRITE);
@@ -2878,6 +2910,13 @@ static int open_input_file(InputFile *ifile, const char *filename)
         AVCodec *codec;
 
         ist->st = stream;
+        ist->next_thumbnail_ts = AV_NOPTS_VALUE;
+
+        /* Only keyframes are wanted: let the demuxer skip everything else
+         * when it can, and have the decoder skip whatever gets through. */
+        if (thumbnails_per_hour > 0 &&
+            stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            stream->discard = AVDISCARD_NONKEY;
 
         if (stream->codecpar->codec_id == AV_CODEC_ID_PROBE) {
             av_log(NULL, AV_LOG_WARNING,
@@ -2897,6 +2936,11 @@ static int open_input_file(InputFile *ifile, const char *filename)
             AVDictionary *opts = filter_codec_opts(codec_opts, stream->codecpar->codec_id,
                                                    fmt_ctx, stream, codec);
 
+            if (stream->discard == AVDISCARD_NONKEY) {
+                av_dict_set(&opts, "skip_frame", "nokey", AV_DICT_DONT_OVERWRITE);
+                av_dict_set(&opts, "skip_loop_filter", "all", AV_DICT_DONT_OVERWRITE);
+            }
+
             ist->dec_ctx = avcodec_alloc_context3(codec);
             if (!ist->dec_ctx)
                 exit(1);
@@ -3517,6 +3561,8 @@ static const OptionDef real_options[] = {
     { "private",           OPT_BOOL, {(void*)&show_private_data}, "same as show_private_data" },
     { "bitexact", OPT_BOOL, {&do_bitexact}, "force bitexact output" },
     { "read_intervals", HAS_ARG, {.func_arg = opt_read_intervals}, "set read intervals", "read_intervals" },
+    { "thumbnails_per_hour", OPT_DOUBLE | HAS_ARG | OPT_EXPERT, {&thumbnails_per_hour},
+        "only read the first video keyframe of each 1/N hour", "N" },
     { "default", HAS_ARG | OPT_AUDIO | OPT_VIDEO | OPT_EXPERT, {.func_arg = opt_default}, "generic catch all option", "" },
     { "i", HAS_ARG, {.func_arg = opt_input_file_i}, "read specified file", "input_file"},
     { "find_stream_info", OPT_BOOL | OPT_INPUT | OPT_EXPERT, { &find_stream_info },
@@ -3706,6 +3706,25 @@ typedef struct AVCodecContext {
      */
     int apply_cropping;
     int disable_multithread_delaying;
+
+    /**
+     * Video decoding only. Wall clock time budget for decoding one packet, in
+     * microseconds, or 0 to disable load shedding (the default).
+     *
+     * When the smoothed decoding time exceeds this budget, libavcodec raises
+     * skip_loop_filter and skip_frame step by step: first the loop filter is
+     * skipped, then non-reference frames, then everything but keyframes. Once
+     * decoding is well within the budget again, it steps back down. Values set
+     * by the user are never lowered. Each output frame carries the current
+     * state as AV_FRAME_DATA_DECODE_LOAD side data.
+     *
+     * This is ignored with frame threading, which does not allow measuring
+     * the decoding time.
+     *
+     * - encoding: unused
+     * - decoding: Set by user.
+     */
+    int64_t decode_deadline;
 } AVCodecContext;
 
 AVRational av_codec_get_pkt_timebase         (const AVCodecContext *avctx);
@@ -36,6 +36,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/intmath.h"
+#include "libavutil/time.h"
 
 #include "avcodec.h"
 #include "bytestream.h"
@@ -357,6 +358,106 @@ static int64_t guess_correct_pts(AVCodecContext *ctx,
     return pts;
 }
 
+/* packets to decode at a level before moving up or down again */
+#define LOAD_MIN_PACKETS    8
+#define LOAD_MIN_HOLDOFF   32
+#define LOAD_MAX_HOLDOFF 1024
+
+static void load_shedding_apply(AVCodecContext *avctx)
+{
+    DecodeLoadContext *load = &avctx->internal->load;
+    enum AVDiscard skip_frame, skip_loop_filter;
+
+    if (!load->holdoff) {
+        load->holdoff               = LOAD_MIN_HOLDOFF;
+        load->user_skip_frame       = avctx->skip_frame;
+        load->user_skip_loop_filter = avctx->skip_loop_filter;
+    } else {
+        /* pick up values changed by the user since the last packet */
+        if (avctx->skip_frame != load->skip_frame)
+            load->user_skip_frame = avctx->skip_frame;
+        if (avctx->skip_loop_filter != load->skip_loop_filter)
+            load->user_skip_loop_filter = avctx->skip_loop_filter;
+    }
+
+    skip_frame       = load->user_skip_frame;
+    skip_loop_filter = load->user_skip_loop_filter;
+    if (load->level >= AV_DECODE_LOAD_SKIP_LOOP_FILTER)
+        skip_loop_filter = FFMAX(skip_loop_filter, AVDISCARD_ALL);
+    if (load->level >= AV_DECODE_LOAD_SKIP_NONREF)
+        skip_frame = FFMAX(skip_frame, AVDISCARD_NONREF);
+    if (load->level >= AV_DECODE_LOAD_KEY_ONLY)
+        skip_frame = FFMAX(skip_frame, AVDISCARD_NONKEY);
+
+    avctx->skip_frame       = load->skip_frame       = skip_frame;
+    avctx->skip_loop_filter = load->skip_loop_filter = skip_loop_filter;
+}
+
+static void load_shedding_update(AVCodecContext *avctx, int64_t time)
+{
+    DecodeLoadContext *load = &avctx->internal->load;
+    int64_t deadline = avctx->decode_deadline;
+    int level = load->level;
+
+    if (!load->decode_time)
+        load->decode_time = time;
+    else
+        load->decode_time += (time - load->decode_time) / 8;
+    load->packets++;
+
+    if (load->decode_time > deadline && level < AV_DECODE_LOAD_KEY_ONLY &&
+        load->packets >= LOAD_MIN_PACKETS) {
+        /* stepping down did not last, be more careful next time */
+        if (load->stepped_down && load->packets < load->holdoff)
+            load->holdoff = FFMIN(2 * load->holdoff, LOAD_MAX_HOLDOFF);
+        load->stepped_down = 0;
+        level++;
+    } else if (load->decode_time < deadline / 2 && level > AV_DECODE_LOAD_NORMAL &&
+               load->packets >= load->holdoff) {
+        load->stepped_down = 1;
+        level--;
+    } else if (load->stepped_down && load->packets >= load->holdoff) {
+        load->stepped_down = 0;
+        load->holdoff = FFMAX(load->holdoff / 2, LOAD_MIN_HOLDOFF);
+    }
+
+    if (level != load->level) {
+        av_log(avctx, AV_LOG_VERBOSE,
+               "Decoding takes %"PRId64" us per packet for a deadline of "
+               "%"PRId64" us, load shedding level %d -> %d\n",
+               load->decode_time, deadline, load->level, level);
+        load->level   = level;
+        load->packets = 0;
+    }
+}
+
+static int load_shedding_enabled(const AVCodecContext *avctx)
+{
+    /* With frame threading, ff_thread_decode_frame() only hands the packet
+     * to a worker and waits for an older frame, so its duration says
+     * nothing about the decoding time. */
+    return avctx->codec->type == AVMEDIA_TYPE_VIDEO && avctx->decode_deadline > 0 &&
+           !(avctx->active_thread_type & FF_THREAD_FRAME);
+}
+
+static int load_shedding_export(AVCodecContext *avctx, AVFrame *frame)
+{
+    DecodeLoadContext *load = &avctx->internal->load;
+    AVFrameSideData *sd;
+    AVDecodeLoad *info;
+
+    sd = av_frame_new_side_data(frame, AV_FRAME_DATA_DECODE_LOAD, sizeof(*info));
+    if (!sd)
+        return AVERROR(ENOMEM);
+
+    info = (AVDecodeLoad *)sd->data;
+    info->level       = load->level;
+    info->decode_time = load->decode_time;
+    info->deadline    = avctx->decode_deadline;
+
+    return 0;
+}
+
 /*
  * The core of the receive_frame_wrapper for the decoders implementing
  * the simple API. Certain decoders might consume partial packets without
@@ -371,6 +472,7 @@ static int decode_simple_internal(AVCodecContext *avctx, AVFrame *frame)
     // copy to ensure we do not change pkt
     AVPacket tmp;
     int got_frame, actual_got_frame, did_split;
+    int64_t decode_start = 0;
     int ret;
 
     if (!pkt->data && !avci->draining) {
@@ -411,6 +513,11 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     got_frame = 0;
 
+    if (load_shedding_enabled(avctx) && pkt->data) {
+        load_shedding_apply(avctx);
+        decode_start = av_gettime_relative();
+    }
+
     if (HAVE_THREADS && avctx->active_thread_type & FF_THREAD_FRAME) {
         ret = ff_thread_decode_frame(avctx, frame, &got_frame, &tmp);
     } else {
@@ -434,6 +541,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
     emms_c();
     actual_got_frame = got_frame;
 
+    if (decode_start)
+        load_shedding_update(avctx, av_gettime_relative() - decode_start);
+
     if (avctx->codec->type == AVMEDIA_TYPE_VIDEO) {
         if (frame->flags & AV_FRAME_FLAG_DISCARD)
             got_frame = 0;
@@ -738,6 +848,14 @@ int attribute_align_arg avcodec_receive_frame(AVCodecContext *avctx, AVFrame *fr
             av_frame_unref(frame);
             return ret;
         }
+
+        if (load_shedding_enabled(avctx)) {
+            ret = load_shedding_export(avctx, frame);
+            if (ret < 0) {
+                av_frame_unref(frame);
+                return ret;
+            }
+        }
     }
 
     avctx->frame_number++;
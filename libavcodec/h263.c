@@ -309,6 +309,7 @@ int16_t *ff_h263_pred_motion(MpegEncContext * s, int block, int dir,
 {
     int wrap;
     int16_t *A, *B, *C, (*mot_val)[2];
+    int16_t zero_mv[2] = { 0 };
     static const int off[4]= {2, 1, 1, -1};
 
     wrap = s->b8_stride;
@@ -347,8 +348,15 @@ int16_t *ff_h263_pred_motion(MpegEncContext * s, int block, int dir,
         }else{ /* block==2*/
             B = mot_val[ - wrap];
             C = mot_val[off[block] - wrap];
-            if(s->mb_x == s->resync_mb_x) //rare
-                A[0]=A[1]=0;
+            if(s->mb_x == s->resync_mb_x){ //rare
+                /* the left MB is in another slice, which slice threads of a
+                 * decoder without B-frames may still be decoding */
+                if (s->encoding || !s->low_delay ||
+                    !(s->avctx->active_thread_type & FF_THREAD_SLICE))
+                    A[0]=A[1]=0;
+                else
+                    A = zero_mv;
+            }
 
             *px = mid_pred(A[0], B[0], C[0]);
             *py = mid_pred(A[1], B[1], C[1]);
@@ -95,6 +95,12 @@ int av_const h263_get_picture_format(int width, int height);
 
 void ff_clean_h263_qscales(MpegEncContext *s);
 int ff_h263_resync(MpegEncContext *s);
+
+/**
+ * Decode the group of blocks / video packet header at the current position.
+ * @return <0 if there is no valid header
+ */
+int ff_h263_decode_resync_header(MpegEncContext *s);
 void ff_h263_encode_motion(PutBitContext *pb, int val, int f_code);
 
 
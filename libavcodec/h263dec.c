@@ -209,7 +209,7 @@ static int decode_slice(MpegEncContext *s)
         const int qscale = s->qscale;
 
         if (CONFIG_MPEG4_DECODER && s->codec_id == AV_CODEC_ID_MPEG4)
-            if ((ret = ff_mpeg4_decode_partitions(s->avctx->priv_data)) < 0)
+            if ((ret = ff_mpeg4_decode_partitions((Mpeg4DecContext *)s)) < 0)
                 return ret;
 
         /* restore variables which were modified */
@@ -242,6 +242,16 @@ static int decode_slice(MpegEncContext *s)
 
             ff_update_block_index(s);
 
+            /* the resync marker was missed, do not run into the MBs of
+             * another slice thread */
+            if (s->mb_y * s->mb_width + s->mb_x >= s->end_mb_num) {
+                av_log(s->avctx, AV_LOG_ERROR, "Slice overrun at MB: %d\n",
+                       s->mb_x + s->mb_y * s->mb_stride);
+                ff_er_add_slice(&s->er, s->resync_mb_x, s->resync_mb_y,
+                                s->mb_x - 1, s->mb_y, ER_MB_ERROR & part_mask);
+                return AVERROR_INVALIDDATA;
+            }
+
             if (s->resync_mb_x == s->mb_x && s->resync_mb_y + 1 == s->mb_y)
                 s->first_slice_line = 0;
 
@@ -406,6 +416,186 @@ static int decode_slice(MpegEncContext *s)
     return AVERROR_INVALIDDATA;
 }
 
+/**
+ * Reset the prediction state at the start of a new video packet / GOB.
+ */
+static void reset_slice_prediction(MpegEncContext *s)
+{
+    if (s->codec_id == AV_CODEC_ID_MPEG4) {
+        /* AC prediction checks the video packet bounds itself */
+        s->last_mv[0][0][0] =
+        s->last_mv[0][0][1] =
+        s->last_mv[1][0][0] =
+        s->last_mv[1][0][1] = 0;
+    } else if (s->msmpeg4_version < 4 && s->h263_pred)
+        ff_mpeg4_clean_buffers(s);
+}
+
+/**
+ * Decode the slice at the current position and the following ones, up to the
+ * end of the picture or the first slice starting at or after s->end_mb_num.
+ */
+static int decode_slices(MpegEncContext *s)
+{
+    int ret = decode_slice(s);
+
+    while (s->mb_y < s->mb_height) {
+        if (s->msmpeg4_version) {
+            if (s->slice_height == 0 || s->mb_x != 0 ||
+                (s->mb_y % s->slice_height) != 0 || get_bits_left(&s->gb) < 0)
+                break;
+        } else {
+            int prev_x = s->mb_x, prev_y = s->mb_y;
+            if (ff_h263_resync(s) < 0)
+                break;
+            if (prev_y * s->mb_width + prev_x < s->mb_y * s->mb_width + s->mb_x)
+                s->er.error_occurred = 1;
+            if (s->mb_y * s->mb_width + s->mb_x >= s->end_mb_num)
+                break;
+        }
+
+        reset_slice_prediction(s);
+
+        if (decode_slice(s) < 0)
+            ret = AVERROR_INVALIDDATA;
+    }
+
+    return ret;
+}
+
+static int slice_decode_thread(AVCodecContext *avctx, void *arg)
+{
+    MpegEncContext *s = *(void **)arg;
+
+    /* all but the first thread start at a video packet / GOB header */
+    if (s != s->thread_context[0]) {
+        if (ff_h263_decode_resync_header(s) < 0)
+            return AVERROR_INVALIDDATA;
+        reset_slice_prediction(s);
+    }
+
+    return decode_slices(s);
+}
+
+/**
+ * Check whether the slices of the current picture can be decoded
+ * concurrently, i.e. nothing but the picture header is shared between them.
+ */
+static int can_decode_slices_threaded(MpegEncContext *s)
+{
+    if (!HAVE_THREADS || !(s->avctx->active_thread_type & FF_THREAD_SLICE) ||
+        s->slice_context_count < 2 || s->avctx->hwaccel)
+        return 0;
+
+    /* P-frame motion vectors at slice starts are altered for B-frames */
+    if (s->pict_type == AV_PICTURE_TYPE_P && !s->low_delay)
+        return 0;
+
+    if (s->codec_id == AV_CODEC_ID_MPEG4)
+        return !s->partitioned_frame && s->pict_type != AV_PICTURE_TYPE_S;
+
+    /* the loop filter, OBMC and advanced intra coding cross GOB boundaries */
+    return (s->codec_id == AV_CODEC_ID_H263 || s->codec_id == AV_CODEC_ID_H263P) &&
+           !s->loop_filter && !s->obmc && !s->h263_aic &&
+           !s->h263_slice_structured && !s->pb_frame;
+}
+
+/**
+ * Split the picture at video packet / GOB headers into ranges of about
+ * equal size and decode them with one slice thread each.
+ * @return 0 or an error code, AVERROR(EAGAIN) if there are not enough slices
+ */
+static int decode_slices_threaded(MpegEncContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    int start_bits[MAX_THREADS], start_mb[MAX_THREADS + 1], rets[MAX_THREADS];
+    const GetBitContext gb = s->gb;
+    const int qscale        = s->qscale;
+    const int chroma_qscale = s->chroma_qscale;
+    const int padding_bug_score = s->padding_bug_score;
+    const uint8_t *buf = gb.buffer;
+    int size = gb.size_in_bits >> 3;
+    int nb_slices = 1, pos, i, ret = 0;
+    int64_t error_count = 0;
+
+    start_bits[0] = get_bits_count(&gb);
+    start_mb[0]   = 0;
+
+    for (pos = (start_bits[0] + 7) >> 3;
+         pos < size - 3 && nb_slices < s->slice_context_count; pos++) {
+        int mb;
+
+        if (buf[pos] || buf[pos + 1])
+            continue;
+        /* stop at the next picture, packed bitstreams may hold several */
+        if (s->codec_id == AV_CODEC_ID_MPEG4 ? buf[pos + 2] == 1
+                                             : (buf[pos + 2] & 0xFC) == 0x80)
+            break;
+
+        s->gb = gb;
+        skip_bits_long(&s->gb, 8 * pos - start_bits[0]);
+        if (ff_h263_decode_resync_header(s) < 0)
+            continue;
+
+        mb = s->mb_y * s->mb_width + s->mb_x;
+        if (mb > start_mb[nb_slices - 1] &&
+            mb >= (int64_t)s->mb_num * nb_slices / s->slice_context_count) {
+            start_bits[nb_slices] = 8 * pos;
+            start_mb[nb_slices++] = mb;
+        }
+    }
+
+    s->gb            = gb;
+    s->mb_x          = 0;
+    s->mb_y          = 0;
+    s->qscale        = qscale;
+    s->chroma_qscale = chroma_qscale;
+
+    if (nb_slices < 2)
+        return AVERROR(EAGAIN);
+
+    start_mb[nb_slices] = s->mb_num;
+    /* the first range is decoded by the main context, set it up last */
+    for (i = nb_slices - 1; i >= 0; i--) {
+        MpegEncContext *t = s->thread_context[i];
+
+        if (i) {
+            ret = ff_update_duplicate_context(t, s);
+            if (ret < 0)
+                return ret;
+            /* codec specific fields following the MpegEncContext */
+            memcpy(t + 1, s + 1, avctx->codec->priv_data_size - sizeof(*s));
+            skip_bits_long(&t->gb, start_bits[i] - start_bits[0]);
+        }
+        t->end_mb_num     = start_mb[i + 1];
+        t->er.error_count = 3 * (start_mb[i + 1] - start_mb[i]);
+    }
+
+    avctx->execute(avctx, slice_decode_thread, s->thread_context, rets,
+                   nb_slices, sizeof(void *));
+
+    for (i = 0; i < nb_slices; i++) {
+        MpegEncContext *t = s->thread_context[i];
+
+        error_count += t->er.error_count;
+        if (i) {
+            s->er.error_occurred |= t->er.error_occurred;
+            s->padding_bug_score += t->padding_bug_score - padding_bug_score;
+        }
+        if (rets[i] < 0)
+            ret = rets[i];
+    }
+    s->er.error_count = FFMIN(error_count, INT_MAX);
+
+    /* the last slice thread ran into the end of the picture */
+    s->gb              = s->thread_context[nb_slices - 1]->gb;
+    s->mb_x            = s->thread_context[nb_slices - 1]->mb_x;
+    s->mb_y            = s->thread_context[nb_slices - 1]->mb_y;
+    s->workaround_bugs = s->thread_context[nb_slices - 1]->workaround_bugs;
+
+    return ret;
+}
+
 int ff_h263_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
                          AVPacket *avpkt)
 {
@@ -631,29 +821,15 @@ retry:
     }
 
     /* decode each macroblock */
-    s->mb_x = 0;
-    s->mb_y = 0;
+    s->mb_x       = 0;
+    s->mb_y       = 0;
+    s->end_mb_num = s->mb_num;
 
-    slice_ret = decode_slice(s);
-    while (s->mb_y < s->mb_height) {
-        if (s->msmpeg4_version) {
-            if (s->slice_height == 0 || s->mb_x != 0 ||
-                (s->mb_y % s->slice_height) != 0 || get_bits_left(&s->gb) < 0)
-                break;
-        } else {
-            int prev_x = s->mb_x, prev_y = s->mb_y;
-            if (ff_h263_resync(s) < 0)
-                break;
-            if (prev_y * s->mb_width + prev_x < s->mb_y * s->mb_width + s->mb_x)
-                s->er.error_occurred = 1;
-        }
-
-        if (s->msmpeg4_version < 4 && s->h263_pred)
-            ff_mpeg4_clean_buffers(s);
-
-        if (decode_slice(s) < 0)
-            slice_ret = AVERROR_INVALIDDATA;
-    }
+    slice_ret = AVERROR(EAGAIN);
+    if (can_decode_slices_threaded(s))
+        slice_ret = decode_slices_threaded(s);
+    if (slice_ret == AVERROR(EAGAIN))
+        slice_ret = decode_slices(s);
 
     if (s->msmpeg4_version && s->msmpeg4_version < 4 &&
         s->pict_type == AV_PICTURE_TYPE_I)
@@ -742,7 +918,8 @@ AVCodec ff_h263_decoder = {
     .close          = ff_h263_decode_end,
     .decode         = ff_h263_decode_frame,
     .capabilities   = AV_CODEC_CAP_DRAW_HORIZ_BAND | AV_CODEC_CAP_DR1 |
-                      AV_CODEC_CAP_TRUNCATED | AV_CODEC_CAP_DELAY,
+                      AV_CODEC_CAP_TRUNCATED | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .flush          = ff_mpeg_flush,
     .max_lowres     = 3,
@@ -759,7 +936,8 @@ AVCodec ff_h263p_decoder = {
     .close          = ff_h263_decode_end,
     .decode         = ff_h263_decode_frame,
     .capabilities   = AV_CODEC_CAP_DRAW_HORIZ_BAND | AV_CODEC_CAP_DR1 |
-                      AV_CODEC_CAP_TRUNCATED | AV_CODEC_CAP_DELAY,
+                      AV_CODEC_CAP_TRUNCATED | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .flush          = ff_mpeg_flush,
     .max_lowres     = 3,
@@ -30,11 +30,10 @@
 #include "h2645_parse.h"
 
 int ff_h2645_extract_rbsp(const uint8_t *src, int length,
-                          H2645NAL *nal, int small_padding)
+                          H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
 {
     int i, si, di;
     uint8_t *dst;
-    int64_t padding = small_padding ? 0 : MAX_MBPAIR_SIZE;
 
     nal->skipped_bytes = 0;
 #define STARTCODE_TEST                                                  \
@@ -91,12 +90,7 @@ int ff_h2645_extract_rbsp(const uint8_t *src, int length,
     } else if (i > length)
         i = length;
 
-    av_fast_padded_malloc(&nal->rbsp_buffer, &nal->rbsp_buffer_size,
-                          length + padding);
-    if (!nal->rbsp_buffer)
-        return AVERROR(ENOMEM);
-
-    dst = nal->rbsp_buffer;
+    dst = &rbsp->rbsp_buffer[rbsp->rbsp_buffer_size];
 
     memcpy(dst, src, i);
     si = di = i;
@@ -144,6 +138,8 @@ nsc:
     nal->size = di;
     nal->raw_data = src;
     nal->raw_size = si;
+    rbsp->rbsp_buffer_size += di + AV_INPUT_BUFFER_PADDING_SIZE;
+
     return si;
 }
 
@@ -247,14 +243,67 @@ static int h264_parse_nal_header(H2645NAL *nal, void *logctx)
     return 1;
 }
 
+/**
+ * Make sure that rbsp_buffer has room for size bytes. The NAL units that
+ * were already unescaped into it are moved along with the data, and the
+ * rest of the new buffer is zeroed, like the padding of
+ * av_fast_padded_malloc(), so that readers overreading a NAL unit do not
+ * see uninitialized data.
+ */
+static int rbsp_reserve(H2645Packet *pkt, int64_t size)
+{
+    H2645RBSP *rbsp = &pkt->rbsp;
+    uint8_t *buf;
+    int i;
+
+    if (size <= rbsp->rbsp_buffer_alloc_size)
+        return 0;
+
+    size += size / 16 + 32;
+    if (size > INT_MAX)
+        return AVERROR(ERANGE);
+
+    buf = av_mallocz(size);
+    if (!buf)
+        return AVERROR(ENOMEM);
+    if (rbsp->rbsp_buffer_size)
+        memcpy(buf, rbsp->rbsp_buffer, rbsp->rbsp_buffer_size);
+
+    for (i = 0; i < pkt->nb_nals; i++) {
+        H2645NAL *nal = &pkt->nals[i];
+        int index = get_bits_count(&nal->gb);
+
+        if (nal->data == nal->raw_data)
+            continue;
+        nal->data = buf + (nal->data - rbsp->rbsp_buffer);
+        init_get_bits(&nal->gb, nal->data, nal->size_bits);
+        skip_bits_long(&nal->gb, index);
+    }
+
+    av_free(rbsp->rbsp_buffer);
+    rbsp->rbsp_buffer            = buf;
+    rbsp->rbsp_buffer_alloc_size = size;
+
+    return 0;
+}
+
 int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
                           void *logctx, int is_nalff, int nal_length_size,
                           enum AVCodecID codec_id, int small_padding)
 {
     int consumed, ret = 0;
     const uint8_t *next_avc = is_nalff ? buf : buf + length;
+    int64_t padding = small_padding ? 0 : MAX_MBPAIR_SIZE;
 
+    /* The unescaped NAL units never take more room than the escaped
+     * packet. Every one of them is followed by its own zeroed padding, the
+     * large padding is only needed once, behind the last one. */
+    pkt->rbsp.rbsp_buffer_size = 0;
     pkt->nb_nals = 0;
+    ret = rbsp_reserve(pkt, (int64_t)length + padding +
+                            4 * AV_INPUT_BUFFER_PADDING_SIZE);
+    if (ret < 0)
+        return ret;
     while (length >= 4) {
         H2645NAL *nal;
         int extract_length = 0;
@@ -326,7 +375,12 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
         }
         nal = &pkt->nals[pkt->nb_nals];
 
-        consumed = ff_h2645_extract_rbsp(buf, extract_length, nal, small_padding);
+        ret = rbsp_reserve(pkt, (int64_t)pkt->rbsp.rbsp_buffer_size + extract_length +
+                                AV_INPUT_BUFFER_PADDING_SIZE + padding);
+        if (ret < 0)
+            return ret;
+
+        consumed = ff_h2645_extract_rbsp(buf, extract_length, &pkt->rbsp, nal, small_padding);
         if (consumed < 0)
             return consumed;
 
@@ -371,10 +425,10 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
 void ff_h2645_packet_uninit(H2645Packet *pkt)
 {
     int i;
-    for (i = 0; i < pkt->nals_allocated; i++) {
-        av_freep(&pkt->nals[i].rbsp_buffer);
+    for (i = 0; i < pkt->nals_allocated; i++)
         av_freep(&pkt->nals[i].skipped_bytes_pos);
-    }
     av_freep(&pkt->nals);
     pkt->nals_allocated = 0;
+    av_freep(&pkt->rbsp.rbsp_buffer);
+    pkt->rbsp.rbsp_buffer_alloc_size = pkt->rbsp.rbsp_buffer_size = 0;
 }
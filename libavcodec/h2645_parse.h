@@ -29,9 +29,6 @@
 #define MAX_MBPAIR_SIZE (256*1024) // a tighter bound could be calculated if someone cares about a few bytes
 
 typedef struct H2645NAL {
-    uint8_t *rbsp_buffer;
-    int rbsp_buffer_size;
-
     int size;
     const uint8_t *data;
 
@@ -65,18 +62,39 @@ typedef struct H2645NAL {
     int ref_idc;
 } H2645NAL;
 
+/**
+ * Buffer holding the unescaped payloads of several NAL units.
+ *
+ * NAL units are unescaped back to back into rbsp_buffer, so that one
+ * allocation serves a whole packet. Each NAL unit is followed by
+ * AV_INPUT_BUFFER_PADDING_SIZE zeroed bytes of its own. NAL units
+ * without emulation prevention bytes are not copied at all when small
+ * padding is allowed, their data points into the input buffer instead.
+ */
+typedef struct H2645RBSP {
+    uint8_t *rbsp_buffer;
+    int rbsp_buffer_alloc_size;
+    int rbsp_buffer_size;
+} H2645RBSP;
+
 /* an input packet split into unescaped NAL units */
 typedef struct H2645Packet {
     H2645NAL *nals;
+    H2645RBSP rbsp;
     int nb_nals;
     int nals_allocated;
 } H2645Packet;
 
 /**
  * Extract the raw (unescaped) bitstream.
+ *
+ * The unescaped data is appended to rbsp->rbsp_buffer, which must have
+ * been allocated by the caller with room for at least length +
+ * AV_INPUT_BUFFER_PADDING_SIZE bytes past rbsp->rbsp_buffer_size, plus
+ * MAX_MBPAIR_SIZE if small_padding is 0.
  */
 int ff_h2645_extract_rbsp(const uint8_t *src, int length,
-                          H2645NAL *nal, int small_padding);
+                          H2645RBSP *rbsp, H2645NAL *nal, int small_padding);
 
 /**
  * Split an input packet into NAL units.
@@ -53,6 +53,7 @@ typedef struct H264ParseContext {
     H264DSPContext h264dsp;
     H264POCContext poc;
     H264SEIContext sei;
+    H2645RBSP rbsp;
     int is_avc;
     int nal_length_size;
     int got_first;
@@ -243,7 +244,7 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                                   const uint8_t * const buf, int buf_size)
 {
     H264ParseContext *p = s->priv_data;
-    H2645NAL nal = { NULL };
+    H2645NAL nal = { 0 };
     int buf_index, next_avc;
     unsigned int pps_id;
     unsigned int slice_type;
@@ -300,7 +301,15 @@ static inline int parse_nal_units(AVCodecParserContext *s,
             }
             break;
         }
-        consumed = ff_h2645_extract_rbsp(buf + buf_index, src_length, &nal, 1);
+        /* every NAL unit is fully parsed before the next one is extracted,
+         * so the unescape buffer is reused instead of reallocated per call */
+        av_fast_padded_malloc(&p->rbsp.rbsp_buffer, &p->rbsp.rbsp_buffer_alloc_size,
+                              src_length);
+        if (!p->rbsp.rbsp_buffer)
+            goto fail;
+        p->rbsp.rbsp_buffer_size = 0;
+
+        consumed = ff_h2645_extract_rbsp(buf + buf_index, src_length, &p->rbsp, &nal, 1);
         if (consumed < 0)
             break;
 
@@ -544,18 +553,14 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                 p->last_frame_num = p->poc.frame_num;
             }
 
-            av_freep(&nal.rbsp_buffer);
             return 0; /* no need to evaluate the rest */
         }
     }
-    if (q264) {
-        av_freep(&nal.rbsp_buffer);
+    if (q264)
         return 0;
-    }
     /* didn't find a picture! */
     av_log(avctx, AV_LOG_ERROR, "missing picture in access unit with size %d\n", buf_size);
 fail:
-    av_freep(&nal.rbsp_buffer);
     return -1;
 }
 
@@ -680,6 +685,7 @@ static void h264_close(AVCodecParserContext *s)
     ParseContext *pc = &p->pc;
 
     av_freep(&pc->buffer);
+    av_freep(&p->rbsp.rbsp_buffer);
 
     ff_h264_sei_uninit(&p->sei);
     ff_h264_ps_uninit(&p->ps);
@@ -128,6 +128,21 @@ typedef struct DecodeFilterContext {
     int         nb_bsfs;
 } DecodeFilterContext;
 
+/* state of the deadline driven load shedding, see decode_deadline */
+typedef struct DecodeLoadContext {
+    int level;              ///< enum AVDecodeLoadLevel
+    int64_t decode_time;    ///< smoothed decoding time per packet, in us
+    int packets;            ///< packets decoded since the last level change
+    int holdoff;            ///< packets to wait before stepping down
+    int stepped_down;       ///< the last level change was a step down
+
+    /* skip settings chosen by the user and the ones we last applied */
+    enum AVDiscard user_skip_frame;
+    enum AVDiscard user_skip_loop_filter;
+    enum AVDiscard skip_frame;
+    enum AVDiscard skip_loop_filter;
+} DecodeLoadContext;
+
 typedef struct AVCodecInternal {
     /**
      * Whether the parent AVCodecContext is a copy of the context which had
@@ -166,6 +181,7 @@ typedef struct AVCodecInternal {
 
     DecodeSimpleContext ds;
     DecodeFilterContext filter;
+    DecodeLoadContext load;
 
     /**
      * Properties (timestamps+side data) extracted from the last packet passed
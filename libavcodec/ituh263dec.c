@@ -206,6 +206,13 @@ static int h263_decode_gob_header(MpegEncContext *s)
     return 0;
 }
 
+int ff_h263_decode_resync_header(MpegEncContext *s)
+{
+    if (CONFIG_MPEG4_DECODER && s->codec_id == AV_CODEC_ID_MPEG4)
+        return ff_mpeg4_decode_video_packet_header((Mpeg4DecContext *)s);
+    return h263_decode_gob_header(s);
+}
+
 /**
  * Decode the group of blocks / video packet header.
  * @return bit position of the resync_marker, or <0 if none was found
@@ -220,10 +227,7 @@ int ff_h263_resync(MpegEncContext *s){
 
     if(show_bits(&s->gb, 16)==0){
         pos= get_bits_count(&s->gb);
-        if(CONFIG_MPEG4_DECODER && s->codec_id==AV_CODEC_ID_MPEG4)
-            ret= ff_mpeg4_decode_video_packet_header(s->avctx->priv_data);
-        else
-            ret= h263_decode_gob_header(s);
+        ret= ff_h263_decode_resync_header(s);
         if(ret>=0)
             return pos;
     }
@@ -237,10 +241,7 @@ int ff_h263_resync(MpegEncContext *s){
             GetBitContext bak= s->gb;
 
             pos= get_bits_count(&s->gb);
-            if(CONFIG_MPEG4_DECODER && s->codec_id==AV_CODEC_ID_MPEG4)
-                ret= ff_mpeg4_decode_video_packet_header(s->avctx->priv_data);
-            else
-                ret= h263_decode_gob_header(s);
+            ret= ff_h263_decode_resync_header(s);
             if(ret>=0)
                 return pos;
 
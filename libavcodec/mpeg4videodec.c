@@ -69,13 +69,19 @@ void ff_mpeg4_pred_ac(MpegEncContext *s, int16_t *block, int n, int dir)
     /* find prediction */
     ac_val  = &s->ac_val[0][0][0] + s->block_index[n] * 16;
     ac_val1 = ac_val;
+    /* Blocks of other video packets are not available for prediction. Skip
+     * them here rather than relying on ff_mpeg4_clean_buffers() having zeroed
+     * them, they may be decoded concurrently by another slice thread. */
     if (s->ac_pred) {
         if (dir == 0) {
             const int xy = s->mb_x - 1 + s->mb_y * s->mb_stride;
             /* left prediction */
             ac_val -= 16;
 
-            if (s->mb_x == 0 || s->qscale == qscale_table[xy] ||
+            if (n != 1 && n != 3 &&
+                s->mb_x == s->resync_mb_x && s->mb_y == s->resync_mb_y) {
+                /* left block in the previous video packet */
+            } else if (s->mb_x == 0 || s->qscale == qscale_table[xy] ||
                 n == 1 || n == 3) {
                 /* same qscale */
                 for (i = 1; i < 8; i++)
@@ -90,7 +96,9 @@ void ff_mpeg4_pred_ac(MpegEncContext *s, int16_t *block, int n, int dir)
             /* top prediction */
             ac_val -= 16 * s->block_wrap[n];
 
-            if (s->mb_y == 0 || s->qscale == qscale_table[xy] ||
+            if (n != 2 && n != 3 && s->first_slice_line) {
+                /* top block in a previous video packet */
+            } else if (s->mb_y == 0 || s->qscale == qscale_table[xy] ||
                 n == 2 || n == 3) {
                 /* same qscale */
                 for (i = 1; i < 8; i++)
@@ -2836,7 +2844,7 @@ AVCodec ff_mpeg4_decoder = {
     .decode                = ff_h263_decode_frame,
     .capabilities          = AV_CODEC_CAP_DRAW_HORIZ_BAND | AV_CODEC_CAP_DR1 |
                              AV_CODEC_CAP_TRUNCATED | AV_CODEC_CAP_DELAY |
-                             AV_CODEC_CAP_FRAME_THREADS,
+                             AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal         = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .flush                 = ff_mpeg_flush,
     .max_lowres            = 3,
@@ -353,6 +353,18 @@ static int alloc_picture(MpegEncContext *s, Picture *pic, int shared)
                             &s->linesize, &s->uvlinesize);
 }
 
+/**
+ * Size of the slice thread contexts. Decoders whose private context starts
+ * with the MpegEncContext get a copy of the whole private context, so that
+ * their own fields are available (and writable) in every slice thread.
+ */
+static size_t duplicate_context_size(MpegEncContext *s)
+{
+    if (s->avctx->codec && s->avctx->priv_data == s)
+        return s->avctx->codec->priv_data_size;
+    return sizeof(MpegEncContext);
+}
+
 static int init_duplicate_context(MpegEncContext *s)
 {
     int y_size = s->b8_stride * (2 * s->mb_height + 1);
@@ -391,7 +403,12 @@ static int init_duplicate_context(MpegEncContext *s)
         FFSWAP(void *, s->pblocks[4], s->pblocks[5]);
     }
 
-    if (s->out_format == FMT_H263) {
+    if (s->out_format == FMT_H263 && !s->encoding && s != s->thread_context[0]) {
+        /* Decoder slice threads only touch the ac values of their own MBs.
+         * Share the ones of the main context, which were copied along with
+         * it, so that the lazy clearing through mbintra_table stays valid. */
+        s->ac_val_base = NULL;
+    } else if (s->out_format == FMT_H263) {
         /* ac values */
         FF_ALLOCZ_OR_GOTO(s->avctx, s->ac_val_base,
                           yc_size * sizeof(int16_t) * 16, fail);
@@ -953,7 +970,7 @@ av_cold int ff_mpv_common_init(MpegEncContext *s)
     if (nb_slices > 1) {
         for (i = 0; i < nb_slices; i++) {
             if (i) {
-                s->thread_context[i] = av_memdup(s, sizeof(MpegEncContext));
+                s->thread_context[i] = av_memdup(s, duplicate_context_size(s));
                 if (!s->thread_context[i])
                     goto fail;
             }
@@ -1082,7 +1099,7 @@ int ff_mpv_common_frame_size_change(MpegEncContext *s)
         if (nb_slices > 1) {
             for (i = 0; i < nb_slices; i++) {
                 if (i) {
-                    s->thread_context[i] = av_memdup(s, sizeof(MpegEncContext));
+                    s->thread_context[i] = av_memdup(s, duplicate_context_size(s));
                     if (!s->thread_context[i]) {
                         err = AVERROR(ENOMEM);
                         goto fail;
@@ -826,6 +826,9 @@ int attribute_align_arg avcodec_open2(AVCodecContext *avctx, const AVCodec *code
     }
     if (!HAVE_THREADS && !(codec->capabilities & AV_CODEC_CAP_AUTO_THREADS))
         avctx->thread_count = 1;
+    if (avctx->decode_deadline > 0 && avctx->active_thread_type & FF_THREAD_FRAME)
+        av_log(avctx, AV_LOG_WARNING,
+               "decode_deadline is ignored with frame threading\n");
 
     if (avctx->codec->max_lowres < avctx->lowres || avctx->lowres < 0) {
         av_log(avctx, AV_LOG_WARNING, "The maximum value for lowres supported by the decoder is %d\n",
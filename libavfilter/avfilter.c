@@ -33,6 +33,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -190,7 +191,12 @@ int avfilter_link_get_channels(AVFilterLink *link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
+    /* in a pipelined graph, both neighbours of a filter may be running */
+    if (filter->graph)
+        ff_graph_pipeline_lock(filter->graph);
     filter->ready = FFMAX(filter->ready, priority);
+    if (filter->graph)
+        ff_graph_pipeline_unlock(filter->graph);
 }
 
 /**
@@ -850,10 +856,94 @@ void avfilter_free(AVFilterContext *filter)
     av_expr_free(filter->enable);
     filter->enable = NULL;
     av_freep(&filter->var_values);
+    if (filter->internal->init_opts) {
+        av_opt_free(filter->internal->init_opts);
+        av_freep(&filter->internal->init_opts);
+    }
+    av_dict_free(&filter->internal->init_dict);
     av_freep(&filter->internal);
     av_free(filter);
 }
 
+int ff_filter_init_clone(AVFilterContext *ctx, const AVFilterContext *src)
+{
+    AVDictionary *options = NULL;
+    int ret;
+
+    if (ctx->filter != src->filter)
+        return AVERROR(EINVAL);
+
+    if (src->internal->init_opts &&
+        (ret = av_opt_copy(ctx->priv, src->internal->init_opts)) < 0)
+        return ret;
+    ctx->thread_type = src->internal->init_thread_type;
+    ctx->nb_threads  = src->nb_threads;
+    if (src->enable_str && (ret = set_enable_expr(ctx, src->enable_str)) < 0)
+        return ret;
+
+    if ((ret = av_dict_copy(&options, src->internal->init_dict, 0)) < 0 ||
+        (ret = avfilter_init_dict(ctx, &options)) < 0)
+        goto end;
+
+    if (ctx->nb_inputs != src->nb_inputs || ctx->nb_outputs != src->nb_outputs) {
+        av_log(ctx, AV_LOG_ERROR, "Pads differ from the cloned filter.\n");
+        ret = AVERROR(EINVAL);
+    }
+
+end:
+    av_dict_free(&options);
+    return ret;
+}
+
+AVFilterStats *avfilter_stats_alloc(void)
+{
+    return av_mallocz(sizeof(AVFilterStats));
+}
+
+AVFilterLinkStats *avfilter_link_stats_alloc(void)
+{
+    return av_mallocz(sizeof(AVFilterLinkStats));
+}
+
+int avfilter_get_stats(const AVFilterContext *filter, AVFilterStats *stats)
+{
+    AVFilterContext *f = (AVFilterContext *)filter;
+    unsigned i;
+
+    /* the counters of a pipelined graph are updated by the workers */
+    ff_filter_pipeline_hold(f);
+    memset(stats, 0, sizeof(*stats));
+    stats->time        = filter->internal->time;
+    stats->activations = filter->internal->activations;
+    for (i = 0; i < filter->nb_inputs; i++) {
+        if (filter->inputs[i]) {
+            stats->frames_in    += filter->inputs[i]->frame_count_out;
+            stats->copied_bytes += filter->inputs[i]->copied_bytes;
+        }
+    }
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i])
+            stats->frames_out += filter->outputs[i]->frame_count_in;
+    ff_filter_pipeline_release(f);
+    return 0;
+}
+
+int avfilter_link_get_stats(const AVFilterLink *link, AVFilterLinkStats *stats)
+{
+    /* holding the source filter keeps the destination idle too */
+    ff_filter_pipeline_hold(link->src);
+    memset(stats, 0, sizeof(*stats));
+    stats->frames_in          = link->frame_count_in;
+    stats->frames_out         = link->frame_count_out;
+    stats->queued_frames      = ff_framequeue_queued_frames(&link->fifo);
+    stats->queued_bytes       = ff_framequeue_queued_bytes(&link->fifo);
+    stats->peak_queued_frames = link->fifo.peak_queued;
+    stats->peak_queued_bytes  = link->fifo.peak_queued_bytes;
+    stats->copied_bytes       = link->copied_bytes;
+    ff_filter_pipeline_release(link->src);
+    return 0;
+}
+
 int ff_filter_get_nb_threads(AVFilterContext *ctx)
 {
      if (ctx->nb_threads > 0)
@@ -956,6 +1046,7 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
+    ctx->internal->init_thread_type = ctx->thread_type;
     if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
         ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
         ctx->graph->internal->thread_execute) {
@@ -971,7 +1062,21 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
             av_log(ctx, AV_LOG_ERROR, "Error applying options to the filter.\n");
             return ret;
         }
+
+        /* keep the options as they are before init, which may modify them,
+         * so that the filter can be cloned */
+        if (!ctx->internal->init_opts) {
+            ctx->internal->init_opts = av_mallocz(ctx->filter->priv_size);
+            if (!ctx->internal->init_opts)
+                return AVERROR(ENOMEM);
+            *(const AVClass **)ctx->internal->init_opts = ctx->filter->priv_class;
+        }
+        if ((ret = av_opt_copy(ctx->internal->init_opts, ctx->priv)) < 0)
+            return ret;
     }
+    if (options && *options &&
+        (ret = av_dict_copy(&ctx->internal->init_dict, *options, 0)) < 0)
+        return ret;
 
     if (ctx->filter->init_opaque)
         ret = ctx->filter->init_opaque(ctx, NULL);
@@ -1127,18 +1232,19 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     if (!(filter_frame = dst->filter_frame))
         filter_frame = default_filter_frame;
 
-    if (dst->needs_writable) {
-        ret = ff_inlink_make_frame_writable(link, &frame);
-        if (ret < 0)
-            goto fail;
-    }
-
     ff_inlink_process_commands(link, frame);
     dstctx->is_disabled = !ff_inlink_evaluate_timeline_at_frame(link, frame);
 
     if (dstctx->is_disabled &&
-        (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
+        (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC)) {
+        /* the frame is passed through, it does not need to be writable */
         filter_frame = default_filter_frame;
+    } else if (dst->needs_writable) {
+        ret = ff_inlink_make_frame_writable(link, &frame);
+        if (ret < 0)
+            goto fail;
+    }
+
     ret = filter_frame(link, frame);
     link->frame_count_out++;
     return ret;
@@ -1491,6 +1597,8 @@ static int ff_filter_activate_default(AVFilterContext *filter)
 
 int ff_filter_activate(AVFilterContext *filter)
 {
+    int measure_time = filter->graph && filter->graph->measure_time;
+    int64_t start = measure_time ? av_gettime_relative() : 0;
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
@@ -1499,6 +1607,9 @@ int ff_filter_activate(AVFilterContext *filter)
     filter->ready = 0;
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
+    if (measure_time)
+        filter->internal->time += av_gettime_relative() - start;
+    filter->internal->activations++;
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
@@ -1558,6 +1669,16 @@ int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
     return 1;
 }
 
+size_t ff_inlink_queued_frames(AVFilterLink *link)
+{
+    return ff_framequeue_queued_frames(&link->fifo);
+}
+
+AVFrame *ff_inlink_peek_frame(AVFilterLink *link, size_t idx)
+{
+    return ff_framequeue_peek(&link->fifo, idx);
+}
+
 int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
                             AVFrame **rframe)
 {
@@ -1578,14 +1699,12 @@ int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
     return 1;
 }
 
-int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
+static int copy_frame(AVFilterLink *link, AVFrame **rframe)
 {
     AVFrame *frame = *rframe;
     AVFrame *out;
     int ret;
 
-    if (av_frame_is_writable(frame))
-        return 0;
     av_log(link->dst, AV_LOG_DEBUG, "Copying data in avfilter.\n");
 
     switch (link->type) {
@@ -1611,12 +1730,17 @@ int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
     case AVMEDIA_TYPE_VIDEO:
         av_image_copy(out->data, out->linesize, (const uint8_t **)frame->data, frame->linesize,
                       frame->format, frame->width, frame->height);
+        link->copied_bytes += av_image_get_buffer_size(frame->format, frame->width,
+                                                       frame->height, 1);
         break;
     case AVMEDIA_TYPE_AUDIO:
         av_samples_copy(out->extended_data, frame->extended_data,
                         0, 0, frame->nb_samples,
                         frame->channels,
                         frame->format);
+        link->copied_bytes += av_samples_get_buffer_size(NULL, frame->channels,
+                                                         frame->nb_samples,
+                                                         frame->format, 1);
         break;
     default:
         av_assert0(!"reached");
@@ -1627,6 +1751,91 @@ int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
     return 0;
 }
 
+/**
+ * Check that each plane of a video frame is held by its own buffer, in
+ * the order of the planes, as allocated by the lavfi frame pools.
+ */
+static int frame_planes_separate(AVFrame *frame, int nb_planes)
+{
+    int i;
+
+    for (i = 0; i < nb_planes; i++)
+        if (!frame->buf[i] || av_frame_get_plane_buffer(frame, i) != frame->buf[i])
+            return 0;
+    return (nb_planes == FF_ARRAY_ELEMS(frame->buf) || !frame->buf[nb_planes]) &&
+           !frame->nb_extended_buf;
+}
+
+int ff_inlink_make_frame_planes_writable(AVFilterLink *link, AVFrame **rframe,
+                                         unsigned planes)
+{
+    AVFrame *frame = *rframe;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    int linesizes[4];
+    unsigned copy = 0;
+    AVFrame *out;
+    int nb_planes, ret, i;
+
+    if (link->type != AVMEDIA_TYPE_VIDEO || !desc || frame->hw_frames_ctx ||
+        desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_PSEUDOPAL |
+                       AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM) ||
+        av_image_fill_linesizes(linesizes, frame->format, frame->width) < 0)
+        return av_frame_is_writable(frame) ? 0 : copy_frame(link, rframe);
+    nb_planes = av_pix_fmt_count_planes(frame->format);
+    if (!frame_planes_separate(frame, nb_planes))
+        return av_frame_is_writable(frame) ? 0 : copy_frame(link, rframe);
+
+    for (i = 0; i < nb_planes; i++)
+        if (planes & (1 << i) && !av_buffer_is_writable(frame->buf[i]))
+            copy |= 1 << i;
+    if (!copy)
+        return 0;
+    av_log(link->dst, AV_LOG_DEBUG, "Copying planes 0x%x in avfilter.\n", copy);
+
+    out = ff_get_video_buffer(link, frame->width, frame->height);
+    if (!out)
+        return AVERROR(ENOMEM);
+    if (!frame_planes_separate(out, nb_planes)) {
+        av_frame_free(&out);
+        return copy_frame(link, rframe);
+    }
+    ret = av_frame_copy_props(out, frame);
+    if (ret < 0) {
+        av_frame_free(&out);
+        return ret;
+    }
+
+    /* copy the planes which are shared, take over the other ones */
+    for (i = 0; i < nb_planes; i++) {
+        if (copy & (1 << i)) {
+            int h = i == 1 || i == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                     : frame->height;
+            av_image_copy_plane(out->data[i], out->linesize[i],
+                                frame->data[i], frame->linesize[i],
+                                linesizes[i], h);
+            link->copied_bytes += (int64_t)linesizes[i] * h;
+        } else {
+            av_buffer_unref(&out->buf[i]);
+            out->buf[i]      = frame->buf[i];
+            out->data[i]     = frame->data[i];
+            out->linesize[i] = frame->linesize[i];
+            frame->buf[i]    = NULL;
+        }
+    }
+
+    av_frame_free(&frame);
+    *rframe = out;
+    return 0;
+}
+
+int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
+{
+    if (av_frame_is_writable(*rframe))
+        return 0;
+    /* only the shared planes of frames from the lavfi pools are copied */
+    return ff_inlink_make_frame_planes_writable(link, rframe, ~0U);
+}
+
 int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
 {
     AVFilterCommand *cmd = link->dst->command_queue;
@@ -332,6 +332,19 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Run filters of the graph concurrently, each on a different frame.
+ *
+ * Only meaningful in AVFilterGraph.thread_type, and must be set before the
+ * graph is configured. Filters that do not share a link are then activated
+ * in parallel by worker threads, and frames are requested ahead so that the
+ * stages of a filter chain overlap. Frame order and the filter API are
+ * unchanged, but frames may still be in flight when
+ * av_buffersrc_add_frame_flags() returns; pushing EOF waits for all of them.
+ * The graph must not be modified after it has been configured.
+ */
+#define AVFILTER_THREAD_PIPELINE (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -626,6 +639,12 @@ struct AVFilterLink {
      */
     int status_out;
 
+    /**
+     * Number of bytes copied to make the frames received on the link
+     * writable.
+     */
+    int64_t copied_bytes;
+
 #endif /* FF_INTERNAL_FIELDS */
 
 };
@@ -922,6 +941,12 @@ typedef struct AVFilterGraph {
     int sink_links_count;
 
     unsigned disable_auto_convert;
+
+    /**
+     * Measure the time spent activating each filter, see AVFilterStats.time.
+     * This reads the clock twice per activation.
+     */
+    int measure_time;
 } AVFilterGraph;
 
 /**
@@ -1014,6 +1039,27 @@ enum {
  */
 int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx);
 
+/**
+ * Create a new filter graph with the same filters, options and links as a
+ * configured graph, using it as a template.
+ *
+ * The new graph must still be configured with avfilter_graph_config(), but
+ * the formats negotiated for src are reused instead of being negotiated
+ * again, as long as the sources and sinks of the new graph still accept
+ * them. Only the properties of the links, such as the video size or the
+ * time base, are then configured. The options of the sources, for example
+ * the size of a buffer source, may be changed between the two calls.
+ *
+ * Hardware frames contexts set with av_buffersrc_parameters_set() are not
+ * copied.
+ *
+ * @param dst pointer where the new graph is put, it must be freed with
+ *            avfilter_graph_free()
+ * @param src a graph configured with avfilter_graph_config()
+ * @return >= 0 in case of success, a negative AVERROR code otherwise
+ */
+int avfilter_graph_clone(AVFilterGraph **dst, const AVFilterGraph *src);
+
 /**
  * Free a graph, destroy its links, and set *graph to NULL.
  * If *graph is NULL, do nothing.
@@ -1164,12 +1210,107 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
  * Dump a graph into a human-readable string representation.
  *
  * @param graph    the graph to dump
- * @param options  formatting options; currently ignored
+ * @param options  formatting options, a list of key=value pairs separated
+ *                 by ':', or NULL to draw the filters and their links;
+ *                 "stats=text" or "stats=json" dumps the statistics of the
+ *                 filters and links instead, see avfilter_get_stats() and
+ *                 avfilter_link_get_stats(); other options are ignored
  * @return  a string, or NULL in case of memory allocation failure;
  *          the string must be freed using av_free
  */
 char *avfilter_graph_dump(AVFilterGraph *graph, const char *options);
 
+/**
+ * Statistics of a filter instance, see avfilter_get_stats().
+ *
+ * sizeof(AVFilterStats) is not a part of the public ABI, new fields may be
+ * added to the end with a minor bump. It must be allocated with
+ * avfilter_stats_alloc() and freed with av_free().
+ */
+typedef struct AVFilterStats {
+    /**
+     * Time spent running the filter, in microseconds. This is the elapsed
+     * time, which includes the work done by other threads for slice
+     * threaded filters. It is only measured when
+     * AVFilterGraph.measure_time is set, and is 0 otherwise.
+     */
+    int64_t time;
+
+    /**
+     * Number of times the filter was activated.
+     */
+    int64_t activations;
+
+    /**
+     * Number of frames consumed from all the inputs.
+     */
+    int64_t frames_in;
+
+    /**
+     * Number of frames sent on all the outputs.
+     */
+    int64_t frames_out;
+
+    /**
+     * Number of bytes copied to make the frames received on all the inputs
+     * writable.
+     */
+    int64_t copied_bytes;
+} AVFilterStats;
+
+/**
+ * Statistics of a link, see avfilter_link_get_stats().
+ *
+ * sizeof(AVFilterLinkStats) is not a part of the public ABI, new fields may
+ * be added to the end with a minor bump. It must be allocated with
+ * avfilter_link_stats_alloc() and freed with av_free().
+ */
+typedef struct AVFilterLinkStats {
+    int64_t frames_in;          ///< frames sent on the link by the source filter
+    int64_t frames_out;         ///< frames consumed by the destination filter
+    size_t queued_frames;       ///< frames currently queued on the link
+    size_t queued_bytes;        ///< size of the buffers of the queued frames
+    size_t peak_queued_frames;  ///< highest number of frames queued at once
+    size_t peak_queued_bytes;   ///< highest size of the queued buffers at once
+    int64_t copied_bytes;       ///< bytes copied to make the frames writable
+} AVFilterLinkStats;
+
+/**
+ * Allocate an AVFilterStats with all fields set to 0.
+ *
+ * @return the new struct, to be freed with av_free(), or NULL on failure
+ */
+AVFilterStats *avfilter_stats_alloc(void);
+
+/**
+ * Allocate an AVFilterLinkStats with all fields set to 0.
+ *
+ * @return the new struct, to be freed with av_free(), or NULL on failure
+ */
+AVFilterLinkStats *avfilter_link_stats_alloc(void);
+
+/**
+ * Get the statistics collected for a filter since it was created.
+ *
+ * The statistics are always collected, except the time, see
+ * AVFilterGraph.measure_time. When the graph is run with
+ * AVFILTER_THREAD_PIPELINE, this waits until neither the filter nor its
+ * neighbours are running; it must not be called from a filter callback.
+ *
+ * @param stats allocated with avfilter_stats_alloc()
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int avfilter_get_stats(const AVFilterContext *filter, AVFilterStats *stats);
+
+/**
+ * Get the statistics collected for a link since it was created.
+ *
+ * @see avfilter_get_stats()
+ * @param stats allocated with avfilter_link_stats_alloc()
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int avfilter_link_get_stats(const AVFilterLink *link, AVFilterLinkStats *stats);
+
 /**
  * Request a frame on the oldest sink link.
  *
@@ -1190,6 +1331,17 @@ char *avfilter_graph_dump(AVFilterGraph *graph, const char *options);
  */
 int avfilter_graph_request_oldest(AVFilterGraph *graph);
 
+/**
+ * Process the frames already sent to the graph as far as possible without
+ * requesting more frames, e.g. before reading the sinks one last time and
+ * reconfiguring the graph. With AVFILTER_THREAD_PIPELINE, this waits for
+ * all the frames in flight.
+ *
+ * @return  0 on success, a negative AVERROR code returned by a filter on
+ *          failure
+ */
+int avfilter_graph_process_pending(AVFilterGraph *graph);
+
 /**
  * @}
  */
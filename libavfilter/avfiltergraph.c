@@ -47,12 +47,15 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "pipeline", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_PIPELINE }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, FLAGS },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, FLAGS },
+    { "measure_time", "measure the time spent in each filter", OFFSET(measure_time),
+        AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, FLAGS },
     { NULL },
 };
 
@@ -75,6 +78,49 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_pipeline_init(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_pipeline_free(AVFilterGraph *graph)
+{
+}
+
+int ff_graph_pipeline_run_once(AVFilterGraph *graph)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_graph_pipeline_drain(AVFilterGraph *graph, AVFilterLink *link)
+{
+    return 0;
+}
+
+void ff_filter_pipeline_enter(AVFilterContext *filter)
+{
+}
+
+void ff_filter_pipeline_leave(AVFilterContext *filter)
+{
+}
+
+void ff_filter_pipeline_hold(AVFilterContext *filter)
+{
+}
+
+void ff_filter_pipeline_release(AVFilterContext *filter)
+{
+}
+
+void ff_graph_pipeline_lock(AVFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_unlock(AVFilterGraph *graph)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -119,6 +165,8 @@ void avfilter_graph_free(AVFilterGraph **graph)
     if (!*graph)
         return;
 
+    ff_graph_pipeline_free(*graph);
+
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
@@ -1261,22 +1309,219 @@ static int graph_insert_fifos(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+static int format_accepted(const AVFilterFormats *fmts, int fmt, int is_sample_rate)
+{
+    unsigned i;
+
+    if (!fmts || (is_sample_rate && !fmts->nb_formats))
+        return 1;
+    for (i = 0; i < fmts->nb_formats; i++)
+        if (fmts->formats[i] == fmt)
+            return 1;
+    return 0;
+}
+
+static int layout_accepted(const AVFilterChannelLayouts *layouts,
+                           const AVFilterLink *link)
+{
+    int i;
+
+    if (!layouts || layouts->all_layouts || layouts->all_counts)
+        return 1;
+    for (i = 0; i < layouts->nb_channel_layouts; i++)
+        if (layouts->channel_layouts[i] == link->channel_layout ||
+            layouts->channel_layouts[i] == FF_COUNT2LAYOUT(link->channels))
+            return 1;
+    return 0;
+}
+
+static int link_formats_accepted(const AVFilterLink *link)
+{
+    if (!format_accepted(link->in_formats,  link->format, 0) ||
+        !format_accepted(link->out_formats, link->format, 0))
+        return 0;
+    if (link->type != AVMEDIA_TYPE_AUDIO)
+        return 1;
+    return format_accepted(link->in_samplerates,  link->sample_rate, 1) &&
+           format_accepted(link->out_samplerates, link->sample_rate, 1) &&
+           layout_accepted(link->in_channel_layouts,  link) &&
+           layout_accepted(link->out_channel_layouts, link);
+}
+
+static void link_formats_unref(AVFilterLink *link)
+{
+    ff_formats_unref(&link->in_formats);
+    ff_formats_unref(&link->out_formats);
+    ff_formats_unref(&link->in_samplerates);
+    ff_formats_unref(&link->out_samplerates);
+    ff_channel_layouts_unref(&link->in_channel_layouts);
+    ff_channel_layouts_unref(&link->out_channel_layouts);
+}
+
+/**
+ * Check that the filters of a cloned graph accept the formats negotiated
+ * for the graph it was cloned from, so that these formats can be kept
+ * instead of being negotiated again.
+ *
+ * query_formats() is run for every filter either way, as some filters set
+ * up private state in it.
+ *
+ * @return 1 if the formats can be kept, 0 if they must be negotiated again,
+ *         a negative AVERROR code on failure
+ */
+static int graph_check_cloned_formats(AVFilterGraph *graph)
+{
+    unsigned i, j;
+    int ret, accepted = 1, pending = 1, progress = 1;
+
+    /* filters depending on the lists of their neighbours are retried until
+     * no more progress is made; if some still cannot tell their formats,
+     * the graph is negotiated again from scratch */
+    while (pending && progress) {
+        pending = progress = 0;
+        for (i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *f = graph->filters[i];
+
+            if (formats_declared(f))
+                continue;
+            if (f->filter->query_formats)
+                ret = filter_query_formats(f);
+            else
+                ret = ff_default_query_formats(f);
+            if (ret == AVERROR(EAGAIN))
+                pending = 1;
+            else if (ret < 0)
+                return ret;
+            else
+                progress = 1;
+        }
+    }
+    if (pending)
+        accepted = 0;
+
+    for (i = 0; i < graph->nb_filters && accepted; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        for (j = 0; j < f->nb_outputs && accepted; j++)
+            accepted = link_formats_accepted(f->outputs[j]);
+    }
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        for (j = 0; j < f->nb_outputs; j++) {
+            AVFilterLink *link = f->outputs[j];
+
+            link_formats_unref(link);
+            if (!accepted) {
+                link->format         = -1;
+                link->sample_rate    = 0;
+                link->channel_layout = 0;
+                link->channels       = 0;
+            }
+        }
+    }
+
+    return accepted;
+}
+
 int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
 {
     int ret;
 
     if ((ret = graph_check_validity(graphctx, log_ctx)))
         return ret;
-    if ((ret = graph_insert_fifos(graphctx, log_ctx)) < 0)
-        return ret;
-    if ((ret = graph_config_formats(graphctx, log_ctx)))
-        return ret;
+    if (graphctx->internal->cloned) {
+        /* the fifos were cloned too, and the formats are kept if no
+         * filter changed in an incompatible way */
+        if ((ret = graph_check_cloned_formats(graphctx)) < 0)
+            return ret;
+        graphctx->internal->cloned = 0;
+        if (!ret && (ret = graph_config_formats(graphctx, log_ctx)))
+            return ret;
+    } else {
+        if ((ret = graph_insert_fifos(graphctx, log_ctx)) < 0)
+            return ret;
+        if ((ret = graph_config_formats(graphctx, log_ctx)))
+            return ret;
+    }
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_pipeline_init(graphctx)) < 0)
+        return ret;
+
+    return 0;
+}
+
+int avfilter_graph_clone(AVFilterGraph **dstp, const AVFilterGraph *src)
+{
+    AVFilterGraph *dst;
+    unsigned i, j, k, m;
+    int ret;
+
+    *dstp = NULL;
+
+    for (i = 0; i < src->nb_filters; i++) {
+        AVFilterContext *f = src->filters[i];
+        for (j = 0; j < f->nb_outputs; j++) {
+            if (!f->outputs[j] || f->outputs[j]->format < 0) {
+                av_log((void *)src, AV_LOG_ERROR,
+                       "Only configured graphs can be cloned.\n");
+                return AVERROR(EINVAL);
+            }
+        }
+    }
+
+    dst = avfilter_graph_alloc();
+    if (!dst)
+        return AVERROR(ENOMEM);
+    if ((ret = av_opt_copy(dst, src)) < 0)
+        goto fail;
+    dst->execute              = src->execute;
+    dst->opaque               = src->opaque;
+    dst->disable_auto_convert = src->disable_auto_convert;
+
+    for (i = 0; i < src->nb_filters; i++) {
+        AVFilterContext *f = src->filters[i];
+        AVFilterContext *nf = avfilter_graph_alloc_filter(dst, f->filter, f->name);
+        if (!nf) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = ff_filter_init_clone(nf, f)) < 0)
+            goto fail;
+    }
+
+    for (i = 0; i < src->nb_filters; i++) {
+        AVFilterContext *f = src->filters[i];
+        for (j = 0; j < f->nb_outputs; j++) {
+            AVFilterLink *link = f->outputs[j], *nlink;
+
+            for (k = 0; k < src->nb_filters && src->filters[k] != link->dst; k++)
+                ;
+            for (m = 0; m < link->dst->nb_inputs && link->dst->inputs[m] != link; m++)
+                ;
+            av_assert0(k < src->nb_filters && m < link->dst->nb_inputs);
+
+            if ((ret = avfilter_link(dst->filters[i], j, dst->filters[k], m)) < 0)
+                goto fail;
+            nlink = dst->filters[i]->outputs[j];
+            nlink->format         = link->format;
+            nlink->sample_rate    = link->sample_rate;
+            nlink->channel_layout = link->channel_layout;
+            nlink->channels       = link->channels;
+        }
+    }
 
+    dst->internal->cloned = 1;
+    *dstp = dst;
     return 0;
+
+fail:
+    avfilter_graph_free(&dst);
+    return ret;
 }
 
 int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
@@ -1298,7 +1543,9 @@ int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const
     for (i = 0; i < graph->nb_filters; i++) {
         AVFilterContext *filter = graph->filters[i];
         if (!strcmp(target, "all") || (filter->name && !strcmp(target, filter->name)) || !strcmp(target, filter->filter->name)) {
+            ff_filter_pipeline_enter(filter);
             r = avfilter_process_command(filter, cmd, arg, res, res_len, flags);
+            ff_filter_pipeline_leave(filter);
             if (r != AVERROR(ENOSYS)) {
                 if ((flags & AVFILTER_CMD_FLAG_ONE) || r < 0)
                     return r;
@@ -1320,18 +1567,22 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
         AVFilterContext *filter = graph->filters[i];
         if(filter && (!strcmp(target, "all") || !strcmp(target, filter->name) || !strcmp(target, filter->filter->name))){
             AVFilterCommand **queue = &filter->command_queue, *next;
+            ff_filter_pipeline_enter(filter);
             while (*queue && (*queue)->time <= ts)
                 queue = &(*queue)->next;
             next = *queue;
             *queue = av_mallocz(sizeof(AVFilterCommand));
-            if (!*queue)
+            if (!*queue) {
+                ff_filter_pipeline_leave(filter);
                 return AVERROR(ENOMEM);
+            }
 
             (*queue)->command = av_strdup(command);
             (*queue)->arg     = av_strdup(arg);
             (*queue)->time    = ts;
             (*queue)->flags   = flags;
             (*queue)->next    = next;
+            ff_filter_pipeline_leave(filter);
             if(flags & AVFILTER_CMD_FLAG_ONE)
                 return 0;
         }
@@ -1385,18 +1636,24 @@ static void heap_bubble_down(AVFilterGraph *graph,
 
 void ff_avfilter_graph_update_heap(AVFilterGraph *graph, AVFilterLink *link)
 {
+    ff_graph_pipeline_lock(graph);
     heap_bubble_up  (graph, link, link->age_index);
     heap_bubble_down(graph, link, link->age_index);
+    ff_graph_pipeline_unlock(graph);
 }
 
 int avfilter_graph_request_oldest(AVFilterGraph *graph)
 {
-    AVFilterLink *oldest = graph->sink_links[0];
+    AVFilterLink *oldest;
     int64_t frame_count;
     int r;
 
-    while (graph->sink_links_count) {
-        oldest = graph->sink_links[0];
+    while (1) {
+        ff_graph_pipeline_lock(graph);
+        oldest = graph->sink_links_count ? graph->sink_links[0] : NULL;
+        ff_graph_pipeline_unlock(graph);
+        if (!oldest)
+            break;
         if (oldest->dst->filter->activate) {
             /* For now, buffersink is the only filter implementing activate. */
             r = av_buffersink_get_frame_flags(oldest->dst, NULL,
@@ -1404,7 +1661,9 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
             if (r != AVERROR_EOF)
                 return r;
         } else {
+            ff_filter_pipeline_enter(oldest->dst);
             r = ff_request_frame(oldest);
+            ff_filter_pipeline_leave(oldest->dst);
         }
         if (r != AVERROR_EOF)
             break;
@@ -1412,24 +1671,47 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
                oldest->dst ? oldest->dst->name : "unknown",
                oldest->dstpad ? oldest->dstpad->name : "unknown");
         /* EOF: remove the link from the heap */
+        ff_graph_pipeline_lock(graph);
         if (oldest->age_index < --graph->sink_links_count)
             heap_bubble_down(graph, graph->sink_links[graph->sink_links_count],
                              oldest->age_index);
         oldest->age_index = -1;
+        ff_graph_pipeline_unlock(graph);
     }
-    if (!graph->sink_links_count)
+    if (!oldest)
         return AVERROR_EOF;
     av_assert1(!oldest->dst->filter->activate);
     av_assert1(oldest->age_index >= 0);
+    ff_filter_pipeline_enter(oldest->dst);
     frame_count = oldest->frame_count_out;
     while (frame_count == oldest->frame_count_out) {
+        ff_filter_pipeline_leave(oldest->dst);
         r = ff_filter_graph_run_once(graph);
+        ff_filter_pipeline_enter(oldest->dst);
         if (r == AVERROR(EAGAIN) &&
             !oldest->frame_wanted_out && !oldest->frame_blocked_in &&
             !oldest->status_in)
             ff_request_frame(oldest);
         else if (r < 0)
-            return r;
+            break;
+        r = 0;
+    }
+    ff_filter_pipeline_leave(oldest->dst);
+    return r;
+}
+
+int avfilter_graph_process_pending(AVFilterGraph *graph)
+{
+    int ret;
+
+    if (graph->internal->pipeline)
+        return ff_graph_pipeline_drain(graph, NULL);
+    while (graph->nb_filters) {
+        ret = ff_filter_graph_run_once(graph);
+        if (ret == AVERROR(EAGAIN))
+            break;
+        if (ret < 0)
+            return ret;
     }
     return 0;
 }
@@ -1440,6 +1722,8 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (graph->internal->pipeline)
+        return ff_graph_pipeline_run_once(graph);
     filter = graph->filters[0];
     for (i = 1; i < graph->nb_filters; i++)
         if (graph->filters[i]->ready > filter->ready)
@@ -94,26 +94,34 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
     if (buf->peeked_frame)
         return return_or_keep_frame(buf, frame, buf->peeked_frame, flags);
 
+    ff_filter_pipeline_enter(ctx);
     while (1) {
         ret = samples ? ff_inlink_consume_samples(inlink, samples, samples, &cur_frame) :
                         ff_inlink_consume_frame(inlink, &cur_frame);
         if (ret < 0) {
-            return ret;
+            break;
         } else if (ret) {
             /* TODO return the frame instead of copying it */
-            return return_or_keep_frame(buf, frame, cur_frame, flags);
+            ret = return_or_keep_frame(buf, frame, cur_frame, flags);
+            break;
         } else if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
-            return status;
+            ret = status;
+            break;
         } else if ((flags & AV_BUFFERSINK_FLAG_NO_REQUEST)) {
-            return AVERROR(EAGAIN);
+            ret = AVERROR(EAGAIN);
+            break;
         } else if (inlink->frame_wanted_out) {
+            ff_filter_pipeline_leave(ctx);
             ret = ff_filter_graph_run_once(ctx->graph);
             if (ret < 0)
                 return ret;
+            ff_filter_pipeline_enter(ctx);
         } else {
             ff_inlink_request_frame(inlink);
         }
     }
+    ff_filter_pipeline_leave(ctx);
+    return ret;
 }
 
 int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
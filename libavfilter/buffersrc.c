@@ -173,10 +173,14 @@ int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFra
     return ret;
 }
 
-static int push_frame(AVFilterGraph *graph)
+static int push_frame(AVFilterGraph *graph, AVFilterLink *link)
 {
     int ret;
 
+    /* pipelined graphs only wait for room unless EOF is pushed */
+    if (graph->internal->pipeline)
+        return ff_graph_pipeline_drain(graph, link);
+
     while (1) {
         ret = ff_filter_graph_run_once(graph);
         if (ret == AVERROR(EAGAIN))
@@ -187,8 +191,7 @@ static int push_frame(AVFilterGraph *graph)
     return 0;
 }
 
-static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
-                                           AVFrame *frame, int flags)
+static int queue_frame(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
     BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
@@ -196,8 +199,6 @@ static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
 
     s->nb_failed_requests = 0;
 
-    if (!frame)
-        return av_buffersrc_close(ctx, AV_NOPTS_VALUE, flags);
     if (s->eof)
         return AVERROR(EINVAL);
 
@@ -248,11 +249,25 @@ static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
         return ret;
     }
 
-    if ((ret = ctx->output_pads[0].request_frame(ctx->outputs[0])) < 0)
+    return ctx->output_pads[0].request_frame(ctx->outputs[0]);
+}
+
+static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
+                                           AVFrame *frame, int flags)
+{
+    int ret;
+
+    if (!frame)
+        return av_buffersrc_close(ctx, AV_NOPTS_VALUE, flags);
+
+    ff_filter_pipeline_enter(ctx);
+    ret = queue_frame(ctx, frame, flags);
+    ff_filter_pipeline_leave(ctx);
+    if (ret < 0)
         return ret;
 
     if ((flags & AV_BUFFERSRC_FLAG_PUSH)) {
-        ret = push_frame(ctx->graph);
+        ret = push_frame(ctx->graph, ctx->outputs[0]);
         if (ret < 0)
             return ret;
     }
@@ -264,9 +279,12 @@ int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
     BufferSourceContext *s = ctx->priv;
 
+    ff_filter_pipeline_enter(ctx);
+    s->nb_failed_requests = 0;
     s->eof = 1;
     ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
-    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
+    ff_filter_pipeline_leave(ctx);
+    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph, NULL) : 0;
 }
 
 static av_cold int init_video(AVFilterContext *ctx)
@@ -292,7 +310,12 @@ static av_cold int init_video(AVFilterContext *ctx)
 
 unsigned av_buffersrc_get_nb_failed_requests(AVFilterContext *buffer_src)
 {
-    return ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    unsigned ret;
+
+    ff_filter_pipeline_enter(buffer_src);
+    ret = ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    ff_filter_pipeline_leave(buffer_src);
+    return ret;
 }
 
 #define OFFSET(x) offsetof(BufferSourceContext, x)
@@ -602,6 +602,38 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
         dst += dst_delta;
         xm += left;
     }
+    if (l2depth == 3 && !hsub && hband == 1) {
+        /* 8 bits mask, one mask value per pixel: glyphs are mostly
+           transparent, and a zero mask leaves the pixel unchanged */
+        const uint8_t *m = mask + xm;
+        for (x = 0; x < w; x++) {
+            if (m[x]) {
+                unsigned a = m[x] * alpha;
+                *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+            }
+            dst += dst_delta;
+        }
+        xm += w;
+        w = 0;
+    } else if (l2depth == 3) {
+        const unsigned shift = hsub + vsub;
+        const uint8_t *m = mask + xm;
+        for (x = 0; x < w; x++) {
+            unsigned t = 0, a;
+            int i, j;
+            for (j = 0; j < hband; j++)
+                for (i = 0; i < 1 << hsub; i++)
+                    t += m[j * mask_linesize + i];
+            if (t) {
+                a = (t >> shift) * alpha;
+                *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+            }
+            dst += dst_delta;
+            m += 1 << hsub;
+        }
+        xm += w << hsub;
+        w = 0;
+    }
     for (x = 0; x < w; x++) {
         blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
                     1 << hsub, hband, hsub + vsub, xm);
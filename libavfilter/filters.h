@@ -102,6 +102,17 @@ int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe);
 int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
                             AVFrame **rframe);
 
+/**
+ * Get the number of frames available on the link.
+ */
+size_t ff_inlink_queued_frames(AVFilterLink *link);
+
+/**
+ * Access a frame in the link fifo without consuming it.
+ * The first frame is numbered 0; the designated frame must exist.
+ */
+AVFrame *ff_inlink_peek_frame(AVFilterLink *link, size_t idx);
+
 /**
  * Make sure a frame is writable.
  * This is similar to av_frame_make_writable() except it uses the link's
@@ -109,6 +120,18 @@ int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
  */
 int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe);
 
+/**
+ * Make sure some planes of a video frame are writable.
+ * The planes which are shared with other frames are copied, the other ones
+ * are kept as they are, including the planes not in the mask which may
+ * stay shared. If the planes of the frame are not held by separate
+ * buffers, the whole frame is made writable.
+ *
+ * @param planes  mask of the planes that must be writable, bit i for plane i
+ */
+int ff_inlink_make_frame_planes_writable(AVFilterLink *link, AVFrame **rframe,
+                                         unsigned planes);
+
 /**
  * Test and acknowledge the change of status on the link.
  *
@@ -44,6 +44,18 @@ static void check_consistency(FFFrameQueue *fq)
 #endif
 }
 
+static size_t frame_bytes(const AVFrame *frame)
+{
+    size_t bytes = 0;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        bytes += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        bytes += frame->extended_buf[i]->size;
+    return bytes;
+}
+
 void ff_framequeue_init(FFFrameQueue *fq, FFFrameQueueGlobal *fqg)
 {
     fq->queue = &fq->first_bucket;
@@ -88,9 +100,13 @@ int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame)
     }
     b = bucket(fq, fq->queued);
     b->frame = frame;
+    b->bytes = frame_bytes(frame);
     fq->queued++;
     fq->total_frames_head++;
     fq->total_samples_head += frame->nb_samples;
+    fq->queued_bytes += b->bytes;
+    fq->peak_queued       = FFMAX(fq->peak_queued,       fq->queued);
+    fq->peak_queued_bytes = FFMAX(fq->peak_queued_bytes, fq->queued_bytes);
     check_consistency(fq);
     return 0;
 }
@@ -107,6 +123,7 @@ AVFrame *ff_framequeue_take(FFFrameQueue *fq)
     fq->tail &= fq->allocated - 1;
     fq->total_frames_tail++;
     fq->total_samples_tail += b->frame->nb_samples;
+    fq->queued_bytes -= b->bytes;
     fq->samples_skipped = 0;
     check_consistency(fq);
     return b->frame;
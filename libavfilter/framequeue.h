@@ -33,6 +33,7 @@
 
 typedef struct FFFrameBucket {
     AVFrame *frame;
+    size_t bytes;
 } FFFrameBucket;
 
 /**
@@ -105,6 +106,21 @@ typedef struct FFFrameQueue {
      */
     int samples_skipped;
 
+    /**
+     * Size of the buffers referenced by the queued frames.
+     */
+    size_t queued_bytes;
+
+    /**
+     * Highest number of frames queued at once.
+     */
+    size_t peak_queued;
+
+    /**
+     * Highest size of the buffers referenced by the frames queued at once.
+     */
+    size_t peak_queued_bytes;
+
 } FFFrameQueue;
 
 /**
@@ -156,6 +172,14 @@ static inline uint64_t ff_framequeue_queued_samples(const FFFrameQueue *fq)
     return fq->total_samples_head - fq->total_samples_tail;
 }
 
+/**
+ * Get the size of the buffers referenced by the queued frames.
+ */
+static inline size_t ff_framequeue_queued_bytes(const FFFrameQueue *fq)
+{
+    return fq->queued_bytes;
+}
+
 /**
  * Update the statistics after a frame accessed using ff_framequeue_peek()
  * was modified.
@@ -23,6 +23,7 @@
 
 #include "libavutil/channel_layout.h"
 #include "libavutil/bprint.h"
+#include "libavutil/dict.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
 #include "internal.h"
@@ -151,11 +152,127 @@ static void avfilter_graph_dump_to_buf(AVBPrint *buf, AVFilterGraph *graph)
     }
 }
 
+static void dump_stats_text(AVBPrint *buf, AVFilterGraph *graph)
+{
+    unsigned i, j;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterStats st;
+
+        avfilter_get_stats(filter, &st);
+        av_bprintf(buf, "%s (%s): time %"PRId64".%03dms activations %"PRId64
+                   " frames in %"PRId64" out %"PRId64" copied %"PRId64" bytes\n",
+                   filter->name, filter->filter->name,
+                   st.time / 1000, (int)(st.time % 1000), st.activations,
+                   st.frames_in, st.frames_out, st.copied_bytes);
+        for (j = 0; j < filter->nb_outputs; j++) {
+            AVFilterLink *l = filter->outputs[j];
+            AVFilterLinkStats lst;
+
+            avfilter_link_get_stats(l, &lst);
+            av_bprintf(buf, "  %s -> %s:%s: frames in %"PRId64" out %"PRId64
+                       " queued %"SIZE_SPECIFIER" (%"SIZE_SPECIFIER" bytes)"
+                       " peak %"SIZE_SPECIFIER" (%"SIZE_SPECIFIER" bytes)\n",
+                       l->srcpad->name, l->dst->name, l->dstpad->name,
+                       lst.frames_in, lst.frames_out,
+                       lst.queued_frames, lst.queued_bytes,
+                       lst.peak_queued_frames, lst.peak_queued_bytes);
+        }
+    }
+}
+
+static void json_string(AVBPrint *buf, const char *str)
+{
+    av_bprint_chars(buf, '"', 1);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            av_bprintf(buf, "\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            av_bprintf(buf, "\\u%04x", *str);
+        else
+            av_bprint_chars(buf, *str, 1);
+    }
+    av_bprint_chars(buf, '"', 1);
+}
+
+static void dump_stats_json(AVBPrint *buf, AVFilterGraph *graph)
+{
+    unsigned i, j;
+
+    av_bprintf(buf, "{\n  \"filters\": [");
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterStats st;
+
+        avfilter_get_stats(filter, &st);
+        av_bprintf(buf, "%s\n    {\n      \"name\": ", i ? "," : "");
+        json_string(buf, filter->name);
+        av_bprintf(buf, ",\n      \"filter\": ");
+        json_string(buf, filter->filter->name);
+        av_bprintf(buf, ",\n      \"time_us\": %"PRId64",\n"
+                   "      \"activations\": %"PRId64",\n"
+                   "      \"frames_in\": %"PRId64",\n"
+                   "      \"frames_out\": %"PRId64",\n"
+                   "      \"copied_bytes\": %"PRId64",\n"
+                   "      \"outputs\": [",
+                   st.time, st.activations, st.frames_in, st.frames_out,
+                   st.copied_bytes);
+        for (j = 0; j < filter->nb_outputs; j++) {
+            AVFilterLink *l = filter->outputs[j];
+            AVFilterLinkStats lst;
+
+            avfilter_link_get_stats(l, &lst);
+            av_bprintf(buf, "%s\n        {\n          \"pad\": ", j ? "," : "");
+            json_string(buf, l->srcpad->name);
+            av_bprintf(buf, ",\n          \"dst\": ");
+            json_string(buf, l->dst->name);
+            av_bprintf(buf, ",\n          \"dst_pad\": ");
+            json_string(buf, l->dstpad->name);
+            av_bprintf(buf, ",\n          \"frames_in\": %"PRId64",\n"
+                       "          \"frames_out\": %"PRId64",\n"
+                       "          \"queued_frames\": %"SIZE_SPECIFIER",\n"
+                       "          \"queued_bytes\": %"SIZE_SPECIFIER",\n"
+                       "          \"peak_queued_frames\": %"SIZE_SPECIFIER",\n"
+                       "          \"peak_queued_bytes\": %"SIZE_SPECIFIER",\n"
+                       "          \"copied_bytes\": %"PRId64"\n"
+                       "        }",
+                       lst.frames_in, lst.frames_out,
+                       lst.queued_frames, lst.queued_bytes,
+                       lst.peak_queued_frames, lst.peak_queued_bytes,
+                       lst.copied_bytes);
+        }
+        av_bprintf(buf, "%s]\n    }", j ? "\n      " : "");
+    }
+    av_bprintf(buf, "%s]\n}\n", i ? "\n  " : "");
+}
+
 char *avfilter_graph_dump(AVFilterGraph *graph, const char *options)
 {
+    AVDictionary *opts = NULL;
+    AVDictionaryEntry *stats = NULL;
     AVBPrint buf;
     char *dump;
 
+    if (options && av_dict_parse_string(&opts, options, "=", ":", 0) >= 0)
+        stats = av_dict_get(opts, "stats", NULL, 0);
+    if (stats) {
+        /* the statistics change as the graph runs, print them only once */
+        av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
+        if (!strcmp(stats->value, "json"))
+            dump_stats_json(&buf, graph);
+        else
+            dump_stats_text(&buf, graph);
+        av_dict_free(&opts);
+        if (!av_bprint_is_complete(&buf)) {
+            av_bprint_finalize(&buf, NULL);
+            return NULL;
+        }
+        av_bprint_finalize(&buf, &dump);
+        return dump;
+    }
+    av_dict_free(&opts);
+
     av_bprint_init(&buf, 0, 0);
     avfilter_graph_dump_to_buf(&buf, graph);
     av_bprint_init(&buf, buf.len + 1, buf.len + 1);
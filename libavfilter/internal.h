@@ -149,10 +149,29 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+    void *pipeline;
+
+    /* the filters were cloned from a configured graph, whose formats are
+     * stored in the links */
+    int cloned;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /* statistics, see avfilter_get_stats() */
+    int64_t time;               ///< time spent in ff_filter_activate()
+    int64_t activations;        ///< number of calls to ff_filter_activate()
+
+    /* options the filter was initialized with, see ff_filter_init_clone() */
+    void *init_opts;            ///< copy of the priv options before init
+    AVDictionary *init_dict;    ///< options passed to the init_dict callback
+    int init_thread_type;       ///< thread_type before init
+
+    /* pipelined execution state, protected by the pipeline lock */
+    int busy;           ///< being activated by a worker or held by the caller
+    int reserved;       ///< the caller is waiting to take the filter
+    unsigned queued;    ///< frames queued on the only input at last release
 };
 
 /**
@@ -378,6 +397,16 @@ int ff_filter_activate(AVFilterContext *filter);
  */
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter);
 
+/**
+ * Initialize a filter with the options another filter of the same kind was
+ * initialized with.
+ *
+ * @param ctx a filter allocated but not initialized yet
+ * @param src an initialized filter
+ * @return >= 0 on success, a negative AVERROR code otherwise
+ */
+int ff_filter_init_clone(AVFilterContext *ctx, const AVFilterContext *src);
+
 /**
  * The filter is aware of hardware frames, and any hardware frame context
  * should not be automatically propagated through it.
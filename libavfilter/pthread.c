@@ -29,14 +29,25 @@
 #include "libavutil/thread.h"
 #include "libavutil/slicethread.h"
 
+#define FF_INTERNAL_FIELDS 1
+#include "framequeue.h"
+
 #include "avfilter.h"
+#include "filters.h"
 #include "internal.h"
 #include "thread.h"
 
+/**
+ * Number of frames a pipelined filter may queue ahead on a link feeding a
+ * single input filter before it stops being scheduled.
+ */
+#define PIPELINE_QUEUE_SIZE 4
+
 typedef struct ThreadContext {
     AVFilterGraph *graph;
     AVSliceThread *thread;
     avfilter_action_func *func;
+    pthread_mutex_t execute_lock;
 
     /* per-execute parameters */
     AVFilterContext *ctx;
@@ -55,6 +66,7 @@ static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb
 static void slice_thread_uninit(ThreadContext *c)
 {
     avpriv_slicethread_free(&c->thread);
+    pthread_mutex_destroy(&c->execute_lock);
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -64,21 +76,31 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
 
     if (nb_jobs <= 0)
         return 0;
+
+    /* pipeline workers may run several slice threaded filters at once */
+    pthread_mutex_lock(&c->execute_lock);
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+    pthread_mutex_unlock(&c->execute_lock);
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
-    if (nb_threads <= 1)
+    if (nb_threads <= 1) {
         avpriv_slicethread_free(&c->thread);
-    return FFMAX(nb_threads, 1);
+        return FFMAX(nb_threads, 1);
+    }
+    if (pthread_mutex_init(&c->execute_lock, NULL)) {
+        avpriv_slicethread_free(&c->thread);
+        return AVERROR(ENOMEM);
+    }
+    return nb_threads;
 }
 
 int ff_graph_thread_init(AVFilterGraph *graph)
@@ -118,3 +140,400 @@ void ff_graph_thread_free(AVFilterGraph *graph)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
 }
+
+/*
+ * Pipelined graph execution.
+ *
+ * The workers pick ready filters the same way ff_filter_graph_run_once()
+ * does, but several filters may be activated at once as long as they do
+ * not share a link: a running filter owns all its links and neighbours can
+ * only be scheduled once it is done. The filter API is thus unchanged, and
+ * since links keep their frames in order, so is the output.
+ *
+ * To keep the stages of a chain busy, a filter with a single input that only
+ * feeds single input filters requests a frame ahead of demand whenever its
+ * input runs empty, as long as fewer than PIPELINE_QUEUE_SIZE frames wait on
+ * its outputs; and a filter is not scheduled while it would feed such a full
+ * queue, unless nothing else can run.
+ */
+
+typedef struct PipelineContext {
+    AVFilterGraph *graph;
+    pthread_t *workers;
+    int nb_workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int running;            ///< activations in progress
+    unsigned completed;     ///< activations completed so far
+    unsigned seen;          ///< completed when the caller last took a filter
+    int error;              ///< first error returned by an activation
+    int quit;
+} PipelineContext;
+
+static int neighbours_idle(AVFilterContext *filter, int check_reserved)
+{
+    unsigned i;
+
+    for (i = 0; i < filter->nb_inputs; i++) {
+        AVFilterInternal *in = filter->inputs[i]->src->internal;
+        if (in->busy || (check_reserved && in->reserved))
+            return 0;
+    }
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterInternal *in = filter->outputs[i]->dst->internal;
+        if (in->busy || (check_reserved && in->reserved))
+            return 0;
+    }
+    return 1;
+}
+
+static int can_schedule(AVFilterContext *filter)
+{
+    return !filter->internal->busy && !filter->internal->reserved &&
+           neighbours_idle(filter, 1);
+}
+
+static int queue_bounded(AVFilterLink *link)
+{
+    return link->dst->nb_inputs == 1;
+}
+
+static int outputs_full(AVFilterContext *filter)
+{
+    unsigned i;
+
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+        if (queue_bounded(link) &&
+            link->dst->internal->queued >= PIPELINE_QUEUE_SIZE)
+            return 1;
+    }
+    return 0;
+}
+
+static AVFilterContext *pick_filter(PipelineContext *pc, int bounded)
+{
+    AVFilterGraph *graph = pc->graph;
+    AVFilterContext *best = NULL;
+    unsigned i;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        /* ready may only be read once no neighbour can be writing it */
+        if (!can_schedule(filter) || !filter->ready)
+            continue;
+        if (bounded && outputs_full(filter))
+            continue;
+        if (!best || filter->ready > best->ready)
+            best = filter;
+    }
+    return best;
+}
+
+static AVFilterContext *next_filter(PipelineContext *pc)
+{
+    AVFilterContext *filter = pick_filter(pc, 1);
+    if (!filter && !pc->running)
+        filter = pick_filter(pc, 0);
+    return filter;
+}
+
+/**
+ * A buffer source that was asked for a frame it does not have: the graph
+ * needs more input from the caller.
+ */
+static int source_starved(PipelineContext *pc)
+{
+    AVFilterGraph *graph = pc->graph;
+    unsigned i, j;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        if (filter->nb_inputs || !can_schedule(filter) || filter->ready)
+            continue;
+        for (j = 0; j < filter->nb_outputs; j++) {
+            AVFilterLink *link = filter->outputs[j];
+            if (link->frame_wanted_out && link->frame_blocked_in &&
+                !link->status_in)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Called by the owner of a filter before giving it back: request input
+ * ahead of demand if there is room downstream.
+ */
+static void read_ahead(AVFilterContext *filter)
+{
+    AVFilterLink *inlink;
+    unsigned i;
+
+    if (filter->nb_inputs != 1)
+        return;
+    /* filters with several inputs balance them by demand, leave them alone */
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+        if (!queue_bounded(link) || link->status_in || link->status_out ||
+            ff_framequeue_queued_frames(&link->fifo) >= PIPELINE_QUEUE_SIZE)
+            return;
+    }
+    /* like a filter asking for input, only once its queue is empty */
+    inlink = filter->inputs[0];
+    if (!inlink->status_in && !inlink->status_out && !inlink->frame_wanted_out &&
+        !ff_framequeue_queued_frames(&inlink->fifo))
+        ff_inlink_request_frame(inlink);
+}
+
+/**
+ * Refresh the queue snapshots of the bounded links of a filter, called
+ * with the pipeline lock held while the filter is still owned.
+ */
+static void update_queued(AVFilterContext *filter)
+{
+    unsigned i;
+
+    if (filter->nb_inputs == 1)
+        filter->internal->queued =
+            ff_framequeue_queued_frames(&filter->inputs[0]->fifo);
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+        if (queue_bounded(link))
+            link->dst->internal->queued = ff_framequeue_queued_frames(&link->fifo);
+    }
+}
+
+static void *pipeline_worker(void *arg)
+{
+    PipelineContext *pc = arg;
+
+    pthread_mutex_lock(&pc->lock);
+    while (!pc->quit) {
+        AVFilterContext *filter = next_filter(pc);
+        int ret;
+
+        if (!filter) {
+            pthread_cond_wait(&pc->cond, &pc->lock);
+            continue;
+        }
+        filter->internal->busy = 1;
+        pc->running++;
+        pthread_mutex_unlock(&pc->lock);
+
+        ret = ff_filter_activate(filter);
+        read_ahead(filter);
+
+        pthread_mutex_lock(&pc->lock);
+        update_queued(filter);
+        filter->internal->busy = 0;
+        pc->running--;
+        pc->completed++;
+        if (ret < 0 && ret != AVERROR(EAGAIN) && !pc->error)
+            pc->error = ret;
+        pthread_cond_broadcast(&pc->cond);
+    }
+    pthread_mutex_unlock(&pc->lock);
+    return NULL;
+}
+
+int ff_graph_pipeline_run_once(AVFilterGraph *graph)
+{
+    PipelineContext *pc = graph->internal->pipeline;
+    unsigned completed;
+    int ret;
+
+    pthread_mutex_lock(&pc->lock);
+    /* anything completed since the caller looked at the graph is progress */
+    completed = pc->seen;
+    pthread_cond_broadcast(&pc->cond);
+    while (1) {
+        if (pc->error) {
+            ret = pc->error;
+            pc->error = 0;
+            break;
+        }
+        if (pc->completed != completed) {
+            ret = 0;
+            break;
+        }
+        if (!next_filter(pc) && (!pc->running || source_starved(pc))) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+        pthread_cond_wait(&pc->cond, &pc->lock);
+    }
+    pc->seen = pc->completed;
+    pthread_mutex_unlock(&pc->lock);
+    return ret;
+}
+
+int ff_graph_pipeline_drain(AVFilterGraph *graph, AVFilterLink *link)
+{
+    PipelineContext *pc = graph->internal->pipeline;
+    int ret = 0;
+
+    pthread_mutex_lock(&pc->lock);
+    pthread_cond_broadcast(&pc->cond);
+    while (1) {
+        if (pc->error) {
+            ret = pc->error;
+            pc->error = 0;
+            break;
+        }
+        if (!pc->running && !next_filter(pc))
+            break;
+        if (link && (!queue_bounded(link) ||
+                     link->dst->internal->queued < PIPELINE_QUEUE_SIZE))
+            break;
+        pthread_cond_wait(&pc->cond, &pc->lock);
+    }
+    pthread_mutex_unlock(&pc->lock);
+    return ret;
+}
+
+void ff_filter_pipeline_enter(AVFilterContext *filter)
+{
+    PipelineContext *pc = filter->graph->internal->pipeline;
+
+    if (!pc)
+        return;
+    pthread_mutex_lock(&pc->lock);
+    filter->internal->reserved++;
+    while (filter->internal->busy || !neighbours_idle(filter, 0))
+        pthread_cond_wait(&pc->cond, &pc->lock);
+    filter->internal->reserved--;
+    filter->internal->busy = 1;
+    pc->seen = pc->completed;
+    pthread_mutex_unlock(&pc->lock);
+}
+
+void ff_filter_pipeline_leave(AVFilterContext *filter)
+{
+    PipelineContext *pc = filter->graph->internal->pipeline;
+
+    if (!pc)
+        return;
+    read_ahead(filter);
+    pthread_mutex_lock(&pc->lock);
+    update_queued(filter);
+    filter->internal->busy = 0;
+    pthread_cond_broadcast(&pc->cond);
+    pthread_mutex_unlock(&pc->lock);
+}
+
+void ff_filter_pipeline_hold(AVFilterContext *filter)
+{
+    PipelineContext *pc = filter->graph->internal->pipeline;
+
+    if (!pc)
+        return;
+    pthread_mutex_lock(&pc->lock);
+    filter->internal->reserved++;
+    while (filter->internal->busy || !neighbours_idle(filter, 0))
+        pthread_cond_wait(&pc->cond, &pc->lock);
+    filter->internal->reserved--;
+    filter->internal->busy = 1;
+    pthread_mutex_unlock(&pc->lock);
+}
+
+void ff_filter_pipeline_release(AVFilterContext *filter)
+{
+    PipelineContext *pc = filter->graph->internal->pipeline;
+
+    if (!pc)
+        return;
+    pthread_mutex_lock(&pc->lock);
+    filter->internal->busy = 0;
+    pthread_cond_broadcast(&pc->cond);
+    pthread_mutex_unlock(&pc->lock);
+}
+
+void ff_graph_pipeline_lock(AVFilterGraph *graph)
+{
+    PipelineContext *pc = graph->internal->pipeline;
+    if (pc)
+        pthread_mutex_lock(&pc->lock);
+}
+
+void ff_graph_pipeline_unlock(AVFilterGraph *graph)
+{
+    PipelineContext *pc = graph->internal->pipeline;
+    if (pc)
+        pthread_mutex_unlock(&pc->lock);
+}
+
+int ff_graph_pipeline_init(AVFilterGraph *graph)
+{
+    PipelineContext *pc;
+    unsigned i;
+    int ret;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_PIPELINE) ||
+        graph->nb_threads <= 1 || graph->internal->pipeline)
+        return 0;
+
+    pc = av_mallocz(sizeof(*pc));
+    if (!pc)
+        return AVERROR(ENOMEM);
+    pc->graph = graph;
+    pc->workers = av_calloc(graph->nb_threads, sizeof(*pc->workers));
+    if (!pc->workers) {
+        av_free(pc);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = pthread_mutex_init(&pc->lock, NULL))) {
+        av_free(pc->workers);
+        av_free(pc);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&pc->cond, NULL))) {
+        pthread_mutex_destroy(&pc->lock);
+        av_free(pc->workers);
+        av_free(pc);
+        return AVERROR(ret);
+    }
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        filter->internal->busy     = 0;
+        filter->internal->reserved = 0;
+        filter->internal->queued   = filter->nb_inputs == 1 ?
+            ff_framequeue_queued_frames(&filter->inputs[0]->fifo) : 0;
+    }
+
+    graph->internal->pipeline = pc;
+    for (i = 0; i < graph->nb_threads; i++) {
+        if ((ret = pthread_create(&pc->workers[i], NULL, pipeline_worker, pc))) {
+            ff_graph_pipeline_free(graph);
+            return AVERROR(ret);
+        }
+        pc->nb_workers++;
+    }
+    av_log(graph, AV_LOG_VERBOSE, "Pipelined execution with %d threads\n",
+           pc->nb_workers);
+    return 0;
+}
+
+void ff_graph_pipeline_free(AVFilterGraph *graph)
+{
+    PipelineContext *pc = graph->internal->pipeline;
+    int i;
+
+    if (!pc)
+        return;
+
+    pthread_mutex_lock(&pc->lock);
+    pc->quit = 1;
+    pthread_cond_broadcast(&pc->cond);
+    pthread_mutex_unlock(&pc->lock);
+    for (i = 0; i < pc->nb_workers; i++)
+        pthread_join(pc->workers[i], NULL);
+
+    pthread_cond_destroy(&pc->cond);
+    pthread_mutex_destroy(&pc->lock);
+    av_freep(&pc->workers);
+    av_freep(&graph->internal->pipeline);
+}
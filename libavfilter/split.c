@@ -83,11 +83,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 
     for (i = 0; i < ctx->nb_outputs; i++) {
         AVFrame *buf_out;
+        int j;
 
         if (ctx->outputs[i]->status_in)
             continue;
-        buf_out = av_frame_clone(frame);
-        if (!buf_out) {
+        /* the last open output takes the frame itself */
+        for (j = i + 1; j < ctx->nb_outputs && ctx->outputs[j]->status_in; j++)
+            ;
+        if (j == ctx->nb_outputs) {
+            buf_out = frame;
+            frame   = NULL;
+        } else if (!(buf_out = av_frame_clone(frame))) {
             ret = AVERROR(ENOMEM);
             break;
         }
@@ -0,0 +1,136 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+/* hue works in place on a frame shared with hstack, so it copies planes */
+static const char *graph_desc =
+    "testsrc=size=64x48:rate=5:duration=2,format=yuv420p,split[a][b];"
+    "[a]hue=h=90[c];[b][c]hstack,buffersink";
+
+#define MAX_FILTERS 16
+
+static int run_graph(AVFilterGraph *graph)
+{
+    AVFilterContext *sink = NULL;
+    AVFrame *frame = av_frame_alloc();
+    int i, ret;
+
+    if (!frame)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < graph->nb_filters; i++)
+        if (!strcmp(graph->filters[i]->filter->name, "buffersink"))
+            sink = graph->filters[i];
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0)
+        av_frame_unref(frame);
+    av_frame_free(&frame);
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+static AVFilterGraph *create_graph(int nb_threads, int pipeline, int measure_time)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+
+    if (!graph)
+        return NULL;
+    graph->nb_threads   = nb_threads;
+    graph->measure_time = measure_time;
+    if (pipeline)
+        graph->thread_type |= AVFILTER_THREAD_PIPELINE;
+    if (avfilter_graph_parse_ptr(graph, graph_desc, NULL, NULL, NULL) < 0 ||
+        avfilter_graph_config(graph, NULL) < 0 ||
+        run_graph(graph) < 0)
+        avfilter_graph_free(&graph);
+    return graph;
+}
+
+int main(void)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterStats *st = avfilter_stats_alloc();
+    AVFilterLinkStats *lst = avfilter_link_stats_alloc();
+    int64_t frames[MAX_FILTERS][2];
+    int i, j, differ = 0, ret = 0;
+
+    avfilter_register_all();
+
+    if (!st || !lst) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    /* without measure_time and threads, every count is deterministic; the
+     * byte counts depend on the buffer alignment and are not printed */
+    if (!(graph = create_graph(1, 0, 0))) {
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+    for (i = 0; i < graph->nb_filters && i < MAX_FILTERS; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        avfilter_get_stats(filter, st);
+        printf("%s: time %"PRId64" activations %"PRId64" frames in %"PRId64
+               " out %"PRId64"%s\n", filter->name, st->time, st->activations,
+               st->frames_in, st->frames_out, st->copied_bytes ? " copied" : "");
+        frames[i][0] = st->frames_in;
+        frames[i][1] = st->frames_out;
+        for (j = 0; j < filter->nb_outputs; j++) {
+            avfilter_link_get_stats(filter->outputs[j], lst);
+            printf("  -> %s: frames in %"PRId64" out %"PRId64" queued %d peak %d\n",
+                   filter->outputs[j]->dst->name, lst->frames_in, lst->frames_out,
+                   (int)lst->queued_frames, (int)lst->peak_queued_frames);
+        }
+    }
+    avfilter_graph_free(&graph);
+
+    /* a pipelined graph processes the same frames */
+    if (!(graph = create_graph(4, 1, 1))) {
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+    for (i = 0; i < graph->nb_filters && i < MAX_FILTERS; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        avfilter_get_stats(filter, st);
+        if (st->frames_in != frames[i][0] || st->frames_out != frames[i][1] ||
+            st->time < 0 || !st->activations)
+            differ++;
+        for (j = 0; j < filter->nb_outputs; j++) {
+            avfilter_link_get_stats(filter->outputs[j], lst);
+            if (lst->frames_in != lst->frames_out || lst->queued_frames ||
+                lst->queued_bytes || lst->peak_queued_frames < 1)
+                differ++;
+        }
+    }
+    printf("pipeline: %d filters, %d statistics differ\n", graph->nb_filters, differ);
+
+end:
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    avfilter_graph_free(&graph);
+    av_free(st);
+    av_free(lst);
+    return ret < 0 || differ;
+}
@@ -0,0 +1,183 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+static const char *graph_desc =
+    "testsrc=size=64x48:rate=5:duration=1,"
+    "drawbox=x=8:y=8:w=16:h=16:color=red@0.5:enable='gte(n,2)',"
+    "scale=32x24,buffersink";
+
+/* amerge sets up its channel routing in query_formats() */
+static const char *audio_graph_desc =
+    "sine=frequency=440:sample_rate=8000:duration=0.5[a];"
+    "sine=frequency=660:sample_rate=8000:duration=0.5[b];"
+    "[a][b]amerge,abuffersink";
+
+static AVFilterContext *find_filter(AVFilterGraph *graph, const char *name)
+{
+    int i;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        if (!strcmp(graph->filters[i]->filter->name, name))
+            return graph->filters[i];
+    return NULL;
+}
+
+#define MAX_FRAMES 16
+
+/* print the frames output by a graph, or only compare them to a reference */
+static int dump_graph(const char *title, AVFilterGraph *graph,
+                      const uint32_t *ref, uint32_t *crcs)
+{
+    AVFilterContext *sink = find_filter(graph, "buffersink");
+    AVFrame *frame = av_frame_alloc();
+    int ret, n = 0, differ = 0;
+
+    if (!frame)
+        return AVERROR(ENOMEM);
+
+    if (sink) {
+        printf("%s: %d filters, %s %dx%d\n", title, graph->nb_filters,
+               av_get_pix_fmt_name(sink->inputs[0]->format),
+               sink->inputs[0]->w, sink->inputs[0]->h);
+    } else {
+        sink = find_filter(graph, "abuffersink");
+        printf("%s: %d filters, %s %d Hz %d channels\n", title, graph->nb_filters,
+               av_get_sample_fmt_name(sink->inputs[0]->format),
+               sink->inputs[0]->sample_rate, sink->inputs[0]->channels);
+    }
+
+    while (n < MAX_FRAMES && (ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        uint32_t crc = 0;
+        int p, y;
+
+        if (frame->nb_samples) {
+            int size = av_samples_get_buffer_size(NULL, frame->channels,
+                                                  frame->nb_samples,
+                                                  frame->format, 1);
+            if (av_sample_fmt_is_planar(frame->format))
+                size /= frame->channels;
+            for (p = 0; p < frame->channels && frame->extended_data[p]; p++)
+                crc = av_adler32_update(crc, frame->extended_data[p], size);
+        } else {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+
+            for (p = 0; p < 4 && frame->data[p]; p++) {
+                int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                         : frame->height;
+                int w = av_image_get_linesize(frame->format, frame->width, p);
+                for (y = 0; y < h; y++)
+                    crc = av_adler32_update(crc, frame->data[p] + y * frame->linesize[p], w);
+            }
+        }
+        crcs[n] = crc;
+        if (!ref)
+            printf("  frame %d pts %"PRId64" adler32 0x%08"PRIx32"\n",
+                   n, frame->pts, crc);
+        else if (ref[n] != crc)
+            differ++;
+        n++;
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+    if (ref)
+        printf("  %d frames, %d differ from the template\n", n, differ);
+    return ret == AVERROR_EOF || ret >= 0 ? 0 : ret;
+}
+
+int main(void)
+{
+    static const enum AVPixelFormat gray[] = { AV_PIX_FMT_GRAY8, AV_PIX_FMT_NONE };
+    AVFilterGraph *graph = NULL, *clone = NULL;
+    uint32_t ref[MAX_FRAMES], crcs[MAX_FRAMES];
+    int ret;
+
+    avfilter_register_all();
+
+    if (!(graph = avfilter_graph_alloc())) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = 1;
+    if ((ret = avfilter_graph_parse_ptr(graph, graph_desc, NULL, NULL, NULL)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    /* cloning is only possible once the template is configured */
+    if ((ret = avfilter_graph_clone(&clone, graph)) < 0 ||
+        (ret = avfilter_graph_config(clone, NULL)) < 0 ||
+        (ret = dump_graph("template", graph, NULL, ref)) < 0 ||
+        (ret = dump_graph("clone", clone, ref, crcs)) < 0)
+        goto end;
+    avfilter_graph_free(&clone);
+
+    /* new properties for the source, the formats are kept */
+    if ((ret = avfilter_graph_clone(&clone, graph)) < 0 ||
+        (ret = av_opt_set(find_filter(clone, "testsrc"), "size", "96x64",
+                          AV_OPT_SEARCH_CHILDREN)) < 0 ||
+        (ret = avfilter_graph_config(clone, NULL)) < 0 ||
+        (ret = dump_graph("clone with a larger source", clone, NULL, crcs)) < 0)
+        goto end;
+    avfilter_graph_free(&clone);
+
+    /* the sink does not accept the template format anymore, the formats
+     * are negotiated again */
+    if ((ret = avfilter_graph_clone(&clone, graph)) < 0 ||
+        (ret = av_opt_set_int_list(find_filter(clone, "buffersink"), "pix_fmts",
+                                   gray, AV_PIX_FMT_NONE,
+                                   AV_OPT_SEARCH_CHILDREN)) < 0 ||
+        (ret = avfilter_graph_config(clone, NULL)) < 0 ||
+        (ret = dump_graph("clone with a gray sink", clone, NULL, crcs)) < 0)
+        goto end;
+    avfilter_graph_free(&clone);
+    avfilter_graph_free(&graph);
+
+    /* filters keeping state from query_formats() must get it in the clone
+     * too, even though the formats of the template are kept */
+    if (!(graph = avfilter_graph_alloc())) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = 1;
+    if ((ret = avfilter_graph_parse_ptr(graph, audio_graph_desc, NULL, NULL, NULL)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0 ||
+        (ret = avfilter_graph_clone(&clone, graph)) < 0 ||
+        (ret = avfilter_graph_config(clone, NULL)) < 0 ||
+        (ret = dump_graph("audio template", graph, NULL, ref)) < 0 ||
+        (ret = dump_graph("audio clone", clone, ref, crcs)) < 0)
+        goto end;
+
+end:
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    avfilter_graph_free(&clone);
+    avfilter_graph_free(&graph);
+    return ret < 0;
+}
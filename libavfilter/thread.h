@@ -25,4 +25,62 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Start the pipeline workers of a graph configured with
+ * AVFILTER_THREAD_PIPELINE. Does nothing for other graphs.
+ */
+int ff_graph_pipeline_init(AVFilterGraph *graph);
+
+/**
+ * Stop and join the pipeline workers, if any.
+ */
+void ff_graph_pipeline_free(AVFilterGraph *graph);
+
+/**
+ * Pipelined counterpart of ff_filter_graph_run_once(): wake the workers and
+ * wait until one activation completed. Returns AVERROR(EAGAIN) when the
+ * graph is idle or waiting for input from a buffer source.
+ */
+int ff_graph_pipeline_run_once(AVFilterGraph *graph);
+
+/**
+ * Wait for the pipeline workers. If link is NULL, wait until the whole graph
+ * is idle, otherwise only until the backlog on link is below the pipeline
+ * queue bound or the graph is idle.
+ */
+int ff_graph_pipeline_drain(AVFilterGraph *graph, AVFilterLink *link);
+
+/**
+ * Take a filter away from the pipeline workers so that the application
+ * thread can access it and its links, e.g. to push or pull frames.
+ * Blocks until the filter and its neighbours are idle.
+ * Does nothing if the graph is not pipelined.
+ */
+void ff_filter_pipeline_enter(AVFilterContext *filter);
+
+/**
+ * Give back a filter taken with ff_filter_pipeline_enter().
+ */
+void ff_filter_pipeline_leave(AVFilterContext *filter);
+
+/**
+ * Keep a filter and its neighbours idle so that their state, e.g. the
+ * statistics, can be read from the application thread. Unlike
+ * ff_filter_pipeline_enter(), nothing is scheduled when it is released.
+ * Does nothing if the graph is not pipelined.
+ */
+void ff_filter_pipeline_hold(AVFilterContext *filter);
+
+/**
+ * Give back a filter taken with ff_filter_pipeline_hold().
+ */
+void ff_filter_pipeline_release(AVFilterContext *filter);
+
+/**
+ * Lock the graph state that may be updated concurrently by the pipeline
+ * workers: the sink links heap and the ready field of idle filters.
+ */
+void ff_graph_pipeline_lock(AVFilterGraph *graph);
+void ff_graph_pipeline_unlock(AVFilterGraph *graph);
+
 #endif /* AVFILTER_THREAD_H */
@@ -21,6 +21,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/imgutils.h"
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -82,8 +83,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *frame)
     AVFilterContext *avctx = link->dst;
     int res;
 
-    if (res = av_frame_make_writable(frame))
+    if ((res = ff_inlink_make_frame_writable(link, &frame)) < 0) {
+        av_frame_free(&frame);
         return res;
+    }
 
     if (res = avctx->internal->execute(avctx, do_colorkey_slice, frame, NULL, FFMIN(frame->height, ff_filter_get_nb_threads(avctx))))
         return res;
@@ -21,6 +21,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/imgutils.h"
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -94,8 +95,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *frame)
     AVFilterContext *ctx = link->dst;
     int ret;
 
-    if (ret = av_frame_make_writable(frame))
+    if ((ret = ff_inlink_make_frame_writable(link, &frame)) < 0) {
+        av_frame_free(&frame);
         return ret;
+    }
 
     if (ret = ctx->internal->execute(ctx, do_despill_slice, frame, NULL, FFMIN(frame->height, ff_filter_get_nb_threads(ctx))))
         return ret;
@@ -148,7 +148,14 @@ typedef struct DrawTextContext {
     AVBPrint expanded_fontcolor;    ///< used to contain the expanded fontcolor spec
     int ft_load_flags;              ///< flags used for loading fonts, see FT_LOAD_*
     FT_Vector *positions;           ///< positions for each element in the text
+    struct Glyph **text_glyphs;     ///< glyph for each element in the text
     size_t nb_positions;            ///< number of elements of positions array
+    AVBPrint layout_text;           ///< expanded text positions were computed for
+    unsigned int layout_fontsize;   ///< font size positions were computed for
+    int layout_valid;               ///< positions match layout_text and layout_fontsize
+    int text_w, text_h;             ///< size of the laid out text
+    int ascent, descent;            ///< max glyph ascent and descent of the laid out text
+    int glyphs_y0, glyphs_y1;       ///< rows covered by the glyph bitmaps, relative to y
     char *textfile;                 ///< file with text to be drawn
     int x;                          ///< x position to start drawing text
     int y;                          ///< y position to start drawing text
@@ -768,12 +775,26 @@ static av_cold int init(AVFilterContext *ctx)
     }
     s->tabsize *= glyph->advance;
 
+    /* render the glyphs of numbers beforehand when the text changes from
+     * frame to frame, so that a running time or counter never needs to
+     * load a glyph while drawing */
+    if (s->exp_mode != EXP_NONE || s->tc_opt_string) {
+        const char *c;
+        for (c = "0123456789:.-/"; *c; c++) {
+            Glyph dummy = { .code = *c, .fontsize = s->fontsize };
+            if (!av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL))
+                load_glyph(ctx, NULL, *c);
+        }
+    }
+
     if (s->exp_mode == EXP_STRFTIME &&
         (strchr(s->text, '%') || strchr(s->text, '\\')))
         av_log(ctx, AV_LOG_WARNING, "expansion=strftime is deprecated.\n");
 
     av_bprint_init(&s->expanded_text, 0, AV_BPRINT_SIZE_UNLIMITED);
     av_bprint_init(&s->expanded_fontcolor, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprint_init(&s->layout_text, 0, AV_BPRINT_SIZE_UNLIMITED);
+    s->layout_valid = 0;
 
     return 0;
 }
@@ -805,7 +826,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     s->x_pexpr = s->y_pexpr = s->a_pexpr = s->fontsize_pexpr = NULL;
 
     av_freep(&s->positions);
+    av_freep(&s->text_glyphs);
     s->nb_positions = 0;
+    s->layout_valid = 0;
 
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
     av_tree_destroy(s->glyphs);
@@ -817,6 +840,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_bprint_finalize(&s->expanded_text, NULL);
     av_bprint_finalize(&s->expanded_fontcolor, NULL);
+    av_bprint_finalize(&s->layout_text, NULL);
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -1166,12 +1190,12 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
+static int draw_glyphs(DrawTextContext *s, uint8_t *data[], int linesize[],
                        int width, int height,
                        FFDrawColor *color,
                        int x, int y, int borderw)
 {
-    char *text = s->expanded_text.str;
+    char *text = s->layout_text.str;
     uint32_t code = 0;
     int i, x1, y1;
     uint8_t *p;
@@ -1179,28 +1203,21 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
 
     for (i = 0, p = text; *p; i++) {
         FT_Bitmap bitmap;
-        Glyph dummy = { 0 };
         GET_UTF8(code, *p++, continue;);
 
         /* skip new line chars, just go to new line */
         if (code == '\n' || code == '\r' || code == '\t')
             continue;
 
-        dummy.code = code;
-        dummy.fontsize = s->fontsize;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+        glyph = s->text_glyphs[i];
 
         bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
 
-        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
-            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
-            return AVERROR(EINVAL);
-
         x1 = s->positions[i].x+s->x+x - borderw;
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
+                      data, linesize, width, height,
                       bitmap.buffer, bitmap.pitch,
                       bitmap.width, bitmap.rows,
                       bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
@@ -1233,89 +1250,42 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Compute the position of each glyph of the expanded text, loading the
+ * glyphs which are not cached yet. Nothing is done if the text and the
+ * font size did not change since the last call.
+ */
+static int layout_text(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
     int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
+    char *text = s->expanded_text.str;
     uint8_t *p;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
+    int glyphs_y0 = INT_MAX, glyphs_y1 = INT_MIN;
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
-
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
-    av_bprint_clear(bp);
-
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
+    if (s->layout_valid && s->layout_fontsize == s->fontsize &&
+        s->layout_text.len == s->expanded_text.len &&
+        !memcmp(s->layout_text.str, text, s->expanded_text.len))
+        return 0;
+    s->layout_valid = 0;
 
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
     if ((len = s->expanded_text.len) > s->nb_positions) {
         if (!(s->positions =
               av_realloc(s->positions, len*sizeof(*s->positions))))
             return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
-
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+        if (!(s->text_glyphs =
+              av_realloc_array(s->text_glyphs, len, sizeof(*s->text_glyphs))))
             return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
-            return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+        s->nb_positions = len;
     }
 
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
-
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p++, continue;);
@@ -1329,6 +1299,12 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
             if (ret < 0)
                 return ret;
         }
+        s->text_glyphs[i] = glyph;
+
+        if (code != '\n' && code != '\r' && code != '\t' &&
+            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
+            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+            return AVERROR(EINVAL);
 
         y_min = FFMIN(glyph->bbox.yMin, y_min);
         y_max = FFMAX(glyph->bbox.yMax, y_max);
@@ -1358,9 +1334,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
 
         /* get glyph */
         prev_glyph = glyph;
-        dummy.code = code;
-        dummy.fontsize = s->fontsize;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+        glyph = s->text_glyphs[i];
 
         /* kerning */
         if (s->use_kerning && prev_glyph && glyph->code) {
@@ -1376,53 +1350,200 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
         else              x += glyph->advance;
     }
 
-    max_text_line_w = FFMAX(x, max_text_line_w);
+    /* rows drawn by draw_glyphs(), which only skips these characters and
+     * uses the last computed position for the other ones */
+    for (i = 0, p = text; *p; i++) {
+        GET_UTF8(code, *p++, continue;);
+        if (code == '\n' || code == '\r' || code == '\t')
+            continue;
+        glyph = s->text_glyphs[i];
+        glyphs_y0 = FFMIN(glyphs_y0, s->positions[i].y - s->borderw);
+        glyphs_y1 = FFMAX(glyphs_y1, s->positions[i].y + (int)glyph->bitmap.rows);
+        if (s->borderw)
+            glyphs_y1 = FFMAX(glyphs_y1, s->positions[i].y - s->borderw +
+                                         (int)glyph->border_bitmap.rows);
+    }
 
-    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = max_text_line_w;
-    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = y + s->max_glyph_h;
+    s->text_w    = FFMAX(x, max_text_line_w);
+    s->text_h    = y + s->max_glyph_h;
+    s->ascent    = y_max;
+    s->descent   = y_min;
+    s->glyphs_y0 = glyphs_y0;
+    s->glyphs_y1 = glyphs_y1;
 
-    s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
-    s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
-    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = y_max;
-    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = y_min;
+    av_bprint_clear(&s->layout_text);
+    av_bprint_append_data(&s->layout_text, text, s->expanded_text.len);
+    if (!av_bprint_is_complete(&s->layout_text))
+        return AVERROR(ENOMEM);
+    s->layout_fontsize = s->fontsize;
+    s->layout_valid    = 1;
 
-    s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
+    return 0;
+}
 
-    s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
-    s->y = s->var_values[VAR_Y] = av_expr_eval(s->y_pexpr, s->var_values, &s->prng);
-    s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
+typedef struct ThreadData {
+    AVFrame *frame;
+    int y0, y1;                     ///< rows of the frame which are drawn
+    int box_w, box_h;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
 
-    update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int sub = s->dc.vsub_max;
+    const int nb_rows = (td->y1 - td->y0 + (1 << sub) - 1) >> sub;
+    /* keep the slices aligned on chroma rows, so that they split the
+     * text exactly where the chroma planes are split */
+    const int slice_start = td->y0 + ((nb_rows *  jobnr     ) / nb_jobs << sub);
+    const int slice_end   = FFMIN(td->y0 + ((nb_rows * (jobnr + 1)) / nb_jobs << sub),
+                                  frame->height);
+    const int width = frame->width, height = slice_end - slice_start;
+    uint8_t *data[4] = { NULL };
+    int plane;
+
+    if (height <= 0)
+        return 0;
 
-    box_w = FFMIN(width - 1 , max_text_line_w);
-    box_h = FFMIN(height - 1, y + s->max_glyph_h);
+    for (plane = 0; plane < s->dc.nb_planes; plane++)
+        data[plane] = frame->data[plane] +
+                      (slice_start >> s->dc.vsub[plane]) * frame->linesize[plane];
 
     /* draw box */
     if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, frame->linesize, width, height,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, data, frame->linesize, width, height,
+                    &td->shadowcolor, s->shadowx, s->shadowy - slice_start, 0);
+
+    if (s->borderw)
+        draw_glyphs(s, data, frame->linesize, width, height,
+                    &td->bordercolor, 0, -slice_start, s->borderw);
+
+    draw_glyphs(s, data, frame->linesize, width, height,
+                &td->fontcolor, 0, -slice_start, 0);
+
+    return 0;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    int ret;
+    int y0, y1, nb_jobs;
+    ThreadData td = { .frame = frame };
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
             return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
     }
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
             return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
+
+    if ((ret = update_fontsize(ctx)) < 0)
         return ret;
 
+    if ((ret = layout_text(ctx)) < 0)
+        return ret;
+
+    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = s->text_w;
+    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = s->text_h;
+
+    s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
+    s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
+    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = s->ascent;
+    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = s->descent;
+
+    s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
+
+    s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
+    s->y = s->var_values[VAR_Y] = av_expr_eval(s->y_pexpr, s->var_values, &s->prng);
+    s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
+
+    update_alpha(s);
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
+
+    td.box_w = FFMIN(width - 1 , s->text_w);
+    td.box_h = FFMIN(height - 1, s->text_h);
+
+    /* only the rows which are drawn on are split between the jobs */
+    y0 = INT_MAX;
+    y1 = INT_MIN;
+    if (s->glyphs_y0 < s->glyphs_y1) {
+        y0 = s->y + s->glyphs_y0;
+        y1 = s->y + s->glyphs_y1;
+        if (s->shadowx || s->shadowy) {
+            y0 = FFMIN(y0, s->y + s->glyphs_y0 + s->borderw + s->shadowy);
+            y1 = FFMAX(y1, s->y + s->glyphs_y1 + s->shadowy);
+        }
+    }
+    if (s->draw_box) {
+        y0 = FFMIN(y0, s->y - s->boxborderw);
+        y1 = FFMAX(y1, s->y - s->boxborderw + td.box_h + s->boxborderw * 2);
+    }
+    td.y0 = ff_draw_round_to_sub(&s->dc, 1, -1, FFMAX(y0, 0));
+    td.y1 = FFMIN(y1, height);
+    if (td.y0 >= td.y1)
+        return 0;
+
+    nb_jobs = FFMIN((td.y1 - td.y0) >> s->dc.vsub_max, ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, draw_text_slice, &td, NULL, FFMAX(nb_jobs, 1));
+
     return 0;
 }
 
@@ -1494,5 +1615,6 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
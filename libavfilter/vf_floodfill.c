@@ -22,6 +22,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/intreadwrite.h"
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -292,8 +293,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *frame)
     const int h = frame->height;
     int ret;
 
-    if (ret = av_frame_make_writable(frame))
+    if ((ret = ff_inlink_make_frame_writable(link, &frame)) < 0) {
+        av_frame_free(&frame);
         return ret;
+    }
 
     if (is_inside(s->x, s->y, w, h)) {
         s->pick_pixel(frame, s->x, s->y, &s0, &s1, &s2, &s3);
@@ -29,6 +29,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/eval.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "internal.h"
@@ -42,6 +43,13 @@ typedef struct GEQContext {
     int planes;                 ///< number of planes
     int is_rgb;
     int bps;
+
+    int stateless[4];           ///< expression can be evaluated in parallel
+    int cacheable[4];           ///< expression only depends on the position
+    uint8_t *cache[4];          ///< plane computed from a cacheable expression
+    double *xs;                 ///< X values of a row, for batch evaluation
+    double *rows;               ///< one row of results per thread
+    int *job_ret;               ///< return values of the slice jobs
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -110,6 +118,8 @@ static double alpha(void *priv, double x, double y) { return getpix(priv, x, y,
 static const char *const var_names[] = {   "X",   "Y",   "W",   "H",   "N",   "SW",   "SH",   "T",        NULL };
 enum                                   { VAR_X, VAR_Y, VAR_W, VAR_H, VAR_N, VAR_SW, VAR_SH, VAR_T, VAR_VARS_NB };
 
+#define NB_FUNCS 5
+
 static av_cold int geq_init(AVFilterContext *ctx)
 {
     GEQContext *geq = ctx->priv;
@@ -165,10 +175,24 @@ static av_cold int geq_init(AVFilterContext *ctx)
         const char *const *func2_names       = geq->is_rgb ? func2_rgb_names : func2_yuv_names;
         double (*func2[])(void *, double, double) = { lum, cb, cr, alpha, p[plane], NULL };
 
+        unsigned vars[VAR_VARS_NB] = { 0 }, funcs[NB_FUNCS] = { 0 };
+        int i;
+
         ret = av_expr_parse(&geq->e[plane], geq->expr_str[plane < 3 && geq->is_rgb ? plane+4 : plane], var_names,
                             NULL, NULL, func2_names, func2, 0, ctx);
         if (ret < 0)
             break;
+
+        /* Expressions which neither keep state nor read the input nor
+         * depend on time (N, T or the wall clock through time()) give the
+         * same plane for every frame. */
+        geq->stateless[plane] = av_expr_is_stateless(geq->e[plane]);
+        av_expr_count_vars(geq->e[plane], vars, VAR_VARS_NB);
+        av_expr_count_func(geq->e[plane], funcs, NB_FUNCS, 2);
+        geq->cacheable[plane] = geq->stateless[plane] && !vars[VAR_N] && !vars[VAR_T];
+        for (i = 0; i < NB_FUNCS; i++)
+            if (funcs[i])
+                geq->cacheable[plane] = 0;
     }
 
 end:
@@ -217,10 +241,24 @@ static int geq_query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
+static void free_buffers(GEQContext *geq)
+{
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(geq->cache); i++)
+        av_freep(&geq->cache[i]);
+    av_freep(&geq->xs);
+    av_freep(&geq->rows);
+    av_freep(&geq->job_ret);
+}
+
 static int geq_config_props(AVFilterLink *inlink)
 {
-    GEQContext *geq = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    int x;
 
     av_assert0(desc);
 
@@ -229,13 +267,64 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->planes = desc->nb_components;
     geq->bps    = desc->comp[0].depth;
 
+    free_buffers(geq);
+    geq->xs      = av_malloc_array(inlink->w, sizeof(*geq->xs));
+    geq->rows    = av_malloc_array(inlink->w, nb_threads * sizeof(*geq->rows));
+    geq->job_ret = av_malloc_array(nb_threads, sizeof(*geq->job_ret));
+    if (!geq->xs || !geq->rows || !geq->job_ret)
+        return AVERROR(ENOMEM);
+    for (x = 0; x < inlink->w; x++)
+        geq->xs[x] = x;
+
+    return 0;
+}
+
+typedef struct ThreadData {
+    int plane;
+    int w, h;
+    uint8_t *dst;
+    int linesize;
+    const double *values;
+} ThreadData;
+
+static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    GEQContext *geq = ctx->priv;
+    ThreadData *td = arg;
+    const int w = td->w;
+    const int slice_start = (td->h *  jobnr   ) / nb_jobs;
+    const int slice_end   = (td->h * (jobnr+1)) / nb_jobs;
+    const double *arrays[VAR_VARS_NB] = { [VAR_X] = geq->xs };
+    double *row = geq->rows + jobnr * w;
+    double values[VAR_VARS_NB];
+    int x, y, ret;
+
+    memcpy(values, td->values, sizeof(values));
+
+    for (y = slice_start; y < slice_end; y++) {
+        values[VAR_Y] = y;
+        ret = av_expr_eval_batch(geq->e[td->plane], row, w, values, arrays, geq);
+        if (ret < 0)
+            return ret;
+        if (geq->bps > 8) {
+            uint16_t *dst16 = (uint16_t *)(td->dst + y * td->linesize);
+            for (x = 0; x < w; x++)
+                dst16[x] = row[x];
+        } else {
+            uint8_t *dst = td->dst + y * td->linesize;
+            for (x = 0; x < w; x++)
+                dst[x] = row[x];
+        }
+    }
+
     return 0;
 }
 
 static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    int plane;
-    GEQContext *geq = inlink->dst->priv;
+    int plane, i;
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
     double values[VAR_VARS_NB] = {
@@ -252,33 +341,50 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
     av_frame_copy_props(out, in);
 
     for (plane = 0; plane < geq->planes && out->data[plane]; plane++) {
-        int x, y;
-        uint8_t *dst = out->data[plane];
-        uint16_t *dst16 = (uint16_t*)out->data[plane];
-        const int linesize = out->linesize[plane];
         const int w = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(inlink->w, geq->hsub) : inlink->w;
         const int h = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(inlink->h, geq->vsub) : inlink->h;
+        const int bytewidth = w * (geq->bps > 8 ? 2 : 1);
+        ThreadData td = {
+            .plane    = plane,
+            .w        = w,
+            .h        = h,
+            .dst      = out->data[plane],
+            .linesize = out->linesize[plane],
+            .values   = values,
+        };
+        int nb_jobs;
+
+        if (geq->cache[plane]) {
+            av_image_copy_plane(out->data[plane], out->linesize[plane],
+                                geq->cache[plane], bytewidth, bytewidth, h);
+            continue;
+        }
 
         values[VAR_W]  = w;
         values[VAR_H]  = h;
         values[VAR_SW] = w / (double)inlink->w;
         values[VAR_SH] = h / (double)inlink->h;
 
-        for (y = 0; y < h; y++) {
-            values[VAR_Y] = y;
-            if (geq->bps > 8) {
-                for (x = 0; x < w; x++) {
-                    values[VAR_X] = x;
-                    dst16[x] = av_expr_eval(geq->e[plane], values, geq);
-                }
-                dst16 += linesize / 2;
-            } else {
-                for (x = 0; x < w; x++) {
-                    values[VAR_X] = x;
-                    dst[x] = av_expr_eval(geq->e[plane], values, geq);
-                }
-                dst += linesize;
+        /* st(), ld() and random() rely on the pixels being evaluated in order */
+        nb_jobs = geq->stateless[plane] ? FFMIN(h, ff_filter_get_nb_threads(ctx)) : 1;
+        ctx->internal->execute(ctx, slice_geq_filter, &td, geq->job_ret, nb_jobs);
+        for (i = 0; i < nb_jobs; i++) {
+            if (geq->job_ret[i] < 0) {
+                av_frame_free(&out);
+                av_frame_free(&geq->picref);
+                return geq->job_ret[i];
+            }
+        }
+
+        if (geq->cacheable[plane]) {
+            geq->cache[plane] = av_malloc(bytewidth * h);
+            if (!geq->cache[plane]) {
+                av_frame_free(&out);
+                av_frame_free(&geq->picref);
+                return AVERROR(ENOMEM);
             }
+            av_image_copy_plane(geq->cache[plane], bytewidth,
+                                out->data[plane], out->linesize[plane], bytewidth, h);
         }
     }
 
@@ -293,6 +399,7 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
 
     for (i = 0; i < FF_ARRAY_ELEMS(geq->e); i++)
         av_expr_free(geq->e[i]);
+    free_buffers(geq);
 }
 
 static const AVFilterPad geq_inputs[] = {
@@ -323,5 +430,5 @@ AVFilter ff_vf_geq = {
     .inputs        = geq_inputs,
     .outputs       = geq_outputs,
     .priv_class    = &geq_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
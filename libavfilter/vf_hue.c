@@ -27,11 +27,11 @@
 
 #include <float.h>
 #include "libavutil/eval.h"
-#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -272,25 +272,22 @@ static void apply_luma_lut(HueContext *s,
 }
 
 static void apply_lut(HueContext *s,
-                      uint8_t *udst, uint8_t *vdst, const int dst_linesize,
-                      uint8_t *usrc, uint8_t *vsrc, const int src_linesize,
-                      int w, int h)
+                      uint8_t *u, uint8_t *v, const int u_linesize,
+                      const int v_linesize, int w, int h)
 {
     int i;
 
     while (h--) {
         for (i = 0; i < w; i++) {
-            const int u = usrc[i];
-            const int v = vsrc[i];
+            const int u0 = u[i];
+            const int v0 = v[i];
 
-            udst[i] = s->lut_u[u][v];
-            vdst[i] = s->lut_v[u][v];
+            u[i] = s->lut_u[u0][v0];
+            v[i] = s->lut_v[u0][v0];
         }
 
-        usrc += src_linesize;
-        vsrc += src_linesize;
-        udst += dst_linesize;
-        vdst += dst_linesize;
+        u += u_linesize;
+        v += v_linesize;
     }
 }
 
@@ -301,22 +298,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpic)
 {
     HueContext *hue = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
-    AVFrame *outpic;
     const int32_t old_hue_sin = hue->hue_sin, old_hue_cos = hue->hue_cos;
     const float old_brightness = hue->brightness;
-    int direct = 0;
-
-    if (av_frame_is_writable(inpic)) {
-        direct = 1;
-        outpic = inpic;
-    } else {
-        outpic = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-        if (!outpic) {
-            av_frame_free(&inpic);
-            return AVERROR(ENOMEM);
-        }
-        av_frame_copy_props(outpic, inpic);
-    }
+    int ret;
 
     hue->var_values[VAR_N]   = inlink->frame_count_out;
     hue->var_values[VAR_T]   = TS2T(inpic->pts, inlink->time_base);
@@ -364,30 +348,25 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpic)
     if (hue->is_first || (old_brightness != hue->brightness && hue->brightness))
         create_luma_lut(hue);
 
-    if (!direct) {
-        if (!hue->brightness)
-            av_image_copy_plane(outpic->data[0], outpic->linesize[0],
-                                inpic->data[0],  inpic->linesize[0],
-                                inlink->w, inlink->h);
-        if (inpic->data[3])
-            av_image_copy_plane(outpic->data[3], outpic->linesize[3],
-                                inpic->data[3],  inpic->linesize[3],
-                                inlink->w, inlink->h);
+    /* the luma plane is only modified with a brightness, the alpha plane
+     * never, they can stay shared with other frames */
+    ret = ff_inlink_make_frame_planes_writable(inlink, &inpic,
+                                               hue->brightness ? 0x7 : 0x6);
+    if (ret < 0) {
+        av_frame_free(&inpic);
+        return ret;
     }
 
-    apply_lut(hue, outpic->data[1], outpic->data[2], outpic->linesize[1],
-              inpic->data[1],  inpic->data[2],  inpic->linesize[1],
+    apply_lut(hue, inpic->data[1], inpic->data[2],
+              inpic->linesize[1], inpic->linesize[2],
               AV_CEIL_RSHIFT(inlink->w, hue->hsub),
               AV_CEIL_RSHIFT(inlink->h, hue->vsub));
     if (hue->brightness)
-        apply_luma_lut(hue, outpic->data[0], outpic->linesize[0],
+        apply_luma_lut(hue, inpic->data[0], inpic->linesize[0],
                        inpic->data[0], inpic->linesize[0], inlink->w, inlink->h);
 
-    if (!direct)
-        av_frame_free(&inpic);
-
     hue->is_first = 0;
-    return ff_filter_frame(outlink, outpic);
+    return ff_filter_frame(outlink, inpic);
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
@@ -21,6 +21,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/imgutils.h"
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -132,8 +133,11 @@ static int filter_frame(AVFilterLink *link, AVFrame *frame)
     LumakeyContext *s = ctx->priv;
     int ret;
 
-    if (ret = av_frame_make_writable(frame))
+    /* only the alpha plane is modified */
+    if ((ret = ff_inlink_make_frame_planes_writable(link, &frame, 1 << 3)) < 0) {
+        av_frame_free(&frame);
         return ret;
+    }
 
     if (ret = ctx->internal->execute(ctx, s->do_lumakey_slice, frame, NULL, FFMIN(frame->height, ff_filter_get_nb_threads(ctx))))
         return ret;
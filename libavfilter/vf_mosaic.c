@@ -0,0 +1,416 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Scale a number of video inputs and place them on a grid, at a fixed
+ * output frame rate, without waiting for inputs which stall.
+ */
+
+#include <float.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#include "avfilter.h"
+#include "drawutils.h"
+#include "filters.h"
+#include "formats.h"
+#include "internal.h"
+#include "video.h"
+
+enum MosaicSync {
+    SYNC_REPEAT,    ///< wait for all inputs, except those which timed out
+    SYNC_ANY,       ///< output as soon as any input reached the output time
+    SYNC_NB
+};
+
+typedef struct MosaicInput {
+    AVFrame *frame;             ///< latest frame due for the output
+    AVFrame *cell;              ///< frame scaled to the cell size
+    struct SwsContext *sws;
+    int64_t time;               ///< timestamp of the latest frame seen, in AV_TIME_BASE_Q
+    int dirty;                  ///< frame has not been scaled to cell yet
+    int eof;
+} MosaicInput;
+
+typedef struct MosaicContext {
+    const AVClass *class;
+    int nb_inputs;
+    int grid_w, grid_h;         ///< number of columns and rows
+    int w, h;                   ///< output size
+    AVRational frame_rate;
+    int sync;
+    int64_t timeout;
+    uint8_t fill_rgba[4];
+
+    int cell_w, cell_h;
+    FFDrawContext draw;
+    FFDrawColor fill;
+
+    MosaicInput *in;
+    AVFrame *canvas;            ///< last output frame, updated in place when possible
+    int64_t next_pts;           ///< timestamp of the next output frame
+    int64_t start_time;         ///< timestamp of the first input frame, in AV_TIME_BASE_Q
+    int *jobs;                  ///< cells to update for the current output frame
+    int nb_jobs;
+} MosaicContext;
+
+#define OFFSET(x) offsetof(MosaicContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption mosaic_options[] = {
+    { "inputs",  "set number of inputs", OFFSET(nb_inputs),  AV_OPT_TYPE_INT, { .i64 = 4 }, 1, 1024, .flags = FLAGS },
+    { "grid",    "set number of columns and rows", OFFSET(grid_w), AV_OPT_TYPE_IMAGE_SIZE, { .str = NULL }, 0, 0, .flags = FLAGS },
+    { "size",    "set output size", OFFSET(w), AV_OPT_TYPE_IMAGE_SIZE, { .str = "1280x720" }, 0, 0, .flags = FLAGS },
+    { "s",       "set output size", OFFSET(w), AV_OPT_TYPE_IMAGE_SIZE, { .str = "1280x720" }, 0, 0, .flags = FLAGS },
+    { "rate",    "set output frame rate", OFFSET(frame_rate), AV_OPT_TYPE_VIDEO_RATE, { .str = "25" }, DBL_MIN, INT_MAX, .flags = FLAGS },
+    { "r",       "set output frame rate", OFFSET(frame_rate), AV_OPT_TYPE_VIDEO_RATE, { .str = "25" }, DBL_MIN, INT_MAX, .flags = FLAGS },
+    { "sync",    "set when output frames are sent", OFFSET(sync), AV_OPT_TYPE_INT, { .i64 = SYNC_REPEAT }, 0, SYNC_NB - 1, .flags = FLAGS, "sync" },
+        { "repeat", "wait for the inputs, repeat the last frame of those which timed out", 0, AV_OPT_TYPE_CONST, { .i64 = SYNC_REPEAT }, 0, 0, FLAGS, "sync" },
+        { "any",    "send a frame as soon as any input reaches its time", 0, AV_OPT_TYPE_CONST, { .i64 = SYNC_ANY }, 0, 0, FLAGS, "sync" },
+    { "timeout", "set how far an input may lag behind the newest input before it is not waited for", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = 0 }, 0, INT64_MAX, .flags = FLAGS },
+    { "fill",    "set the color of the empty areas", OFFSET(fill_rgba), AV_OPT_TYPE_COLOR, { .str = "black" }, 0, 0, .flags = FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(mosaic);
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    MosaicContext *s = ctx->priv;
+    int i, ret;
+
+    s->in   = av_calloc(s->nb_inputs, sizeof(*s->in));
+    s->jobs = av_calloc(s->nb_inputs, sizeof(*s->jobs));
+    if (!s->in || !s->jobs)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < s->nb_inputs; i++) {
+        AVFilterPad pad = { 0 };
+
+        s->in[i].time = AV_NOPTS_VALUE;
+
+        pad.type = AVMEDIA_TYPE_VIDEO;
+        pad.name = av_asprintf("input%d", i);
+        if (!pad.name)
+            return AVERROR(ENOMEM);
+
+        if ((ret = ff_insert_inpad(ctx, i, &pad)) < 0) {
+            av_freep(&pad.name);
+            return ret;
+        }
+    }
+
+    if (!s->grid_w || !s->grid_h) {
+        s->grid_w = ceil(sqrt(s->nb_inputs));
+        s->grid_h = (s->nb_inputs + s->grid_w - 1) / s->grid_w;
+    } else if (s->grid_w * s->grid_h < s->nb_inputs) {
+        av_log(ctx, AV_LOG_ERROR, "A %dx%d grid cannot hold %d inputs.\n",
+               s->grid_w, s->grid_h, s->nb_inputs);
+        return AVERROR(EINVAL);
+    }
+    s->next_pts   = AV_NOPTS_VALUE;
+    s->start_time = AV_NOPTS_VALUE;
+
+    return 0;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    MosaicContext *s = ctx->priv;
+    int i;
+
+    for (i = 0; i < ctx->nb_inputs; i++)
+        av_freep(&ctx->input_pads[i].name);
+    if (s->in) {
+        for (i = 0; i < s->nb_inputs; i++) {
+            av_frame_free(&s->in[i].frame);
+            av_frame_free(&s->in[i].cell);
+            sws_freeContext(s->in[i].sws);
+        }
+    }
+    av_freep(&s->in);
+    av_freep(&s->jobs);
+    av_frame_free(&s->canvas);
+}
+
+/* free a list built with ff_add_format() that nothing references yet */
+static void free_formats(AVFilterFormats **formats)
+{
+    if (*formats && !(*formats)->refcount) {
+        av_freep(&(*formats)->formats);
+        av_freep(formats);
+    }
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AVFilterFormats *in_fmts = NULL, *out_fmts = NULL;
+    AVFilterFormats *draw_fmts = ff_draw_supported_pixel_formats(0);
+    int i, fmt, ret;
+
+    if (!draw_fmts)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < draw_fmts->nb_formats; i++) {
+        fmt = draw_fmts->formats[i];
+        if (sws_isSupportedOutput(fmt) &&
+            (ret = ff_add_format(&out_fmts, fmt)) < 0)
+            goto fail;
+    }
+    for (fmt = 0; av_pix_fmt_desc_get(fmt); fmt++) {
+        if (sws_isSupportedInput(fmt) &&
+            (ret = ff_add_format(&in_fmts, fmt)) < 0)
+            goto fail;
+    }
+
+    /* the lists referenced by a link are freed with the graph */
+    for (i = 0; i < ctx->nb_inputs; i++)
+        if ((ret = ff_formats_ref(in_fmts, &ctx->inputs[i]->out_formats)) < 0)
+            goto fail;
+    ret = ff_formats_ref(out_fmts, &ctx->outputs[0]->in_formats);
+
+fail:
+    free_formats(&draw_fmts);
+    free_formats(&in_fmts);
+    free_formats(&out_fmts);
+    return ret;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    MosaicContext *s = ctx->priv;
+    int ret;
+
+    if ((ret = ff_draw_init(&s->draw, outlink->format, 0)) < 0)
+        return ret;
+    ff_draw_color(&s->draw, &s->fill, s->fill_rgba);
+
+    /* keep the cells aligned on the chroma samples, and their luma
+     * offsets on a cache line when they are large enough */
+    s->cell_w = s->w / s->grid_w;
+    s->cell_w &= s->cell_w >= 128 ? ~31 : ~((1 << s->draw.hsub_max) - 1);
+    s->cell_h = s->h / s->grid_h;
+    s->cell_h &= ~((1 << s->draw.vsub_max) - 1);
+    if (!s->cell_w || !s->cell_h) {
+        av_log(ctx, AV_LOG_ERROR, "Size %dx%d too small for a %dx%d grid.\n",
+               s->w, s->h, s->grid_w, s->grid_h);
+        return AVERROR(EINVAL);
+    }
+
+    outlink->w                   = s->w;
+    outlink->h                   = s->h;
+    outlink->frame_rate          = s->frame_rate;
+    outlink->time_base           = av_inv_q(s->frame_rate);
+    outlink->sample_aspect_ratio = (AVRational){ 1, 1 };
+
+    return 0;
+}
+
+static int draw_cells(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MosaicContext *s = ctx->priv;
+    AVFrame *canvas = s->canvas;
+    const int start = (s->nb_jobs *  jobnr     ) / nb_jobs;
+    const int end   = (s->nb_jobs * (jobnr + 1)) / nb_jobs;
+    int j;
+
+    for (j = start; j < end; j++) {
+        const int i = s->jobs[j];
+        MosaicInput *in = &s->in[i];
+
+        /* scale into a cell sized frame rather than the canvas, as the
+         * scalers may write a few bytes past the end of the lines */
+        if (in->dirty) {
+            AVFrame *frame = in->frame;
+
+            in->sws = sws_getCachedContext(in->sws, frame->width, frame->height,
+                                           frame->format, s->cell_w, s->cell_h,
+                                           canvas->format, SWS_BILINEAR,
+                                           NULL, NULL, NULL);
+            if (!in->sws)
+                return AVERROR(EINVAL);
+            sws_scale(in->sws, (const uint8_t * const *)frame->data, frame->linesize,
+                      0, frame->height, in->cell->data, in->cell->linesize);
+            in->dirty = 0;
+        }
+        ff_copy_rectangle2(&s->draw, canvas->data, canvas->linesize,
+                           in->cell->data, in->cell->linesize,
+                           i % s->grid_w * s->cell_w, i / s->grid_w * s->cell_h,
+                           0, 0, s->cell_w, s->cell_h);
+    }
+
+    return 0;
+}
+
+static int output_frame(AVFilterContext *ctx)
+{
+    MosaicContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    AVFrame *out;
+    int i, ret, redraw = 0;
+
+    /* the last output frame is reused unless it is still referenced */
+    if (!s->canvas || !av_frame_is_writable(s->canvas)) {
+        av_frame_free(&s->canvas);
+        s->canvas = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!s->canvas)
+            return AVERROR(ENOMEM);
+        ff_fill_rectangle(&s->draw, &s->fill, s->canvas->data, s->canvas->linesize,
+                          0, 0, outlink->w, outlink->h);
+        redraw = 1;
+    }
+
+    s->nb_jobs = 0;
+    for (i = 0; i < s->nb_inputs; i++) {
+        MosaicInput *in = &s->in[i];
+
+        if (!in->frame || !(in->dirty || redraw))
+            continue;
+        if (!in->cell) {
+            if (!(in->cell = av_frame_alloc()))
+                return AVERROR(ENOMEM);
+            in->cell->format = outlink->format;
+            in->cell->width  = s->cell_w;
+            in->cell->height = s->cell_h;
+            if ((ret = av_frame_get_buffer(in->cell, 32)) < 0)
+                return ret;
+        }
+        s->jobs[s->nb_jobs++] = i;
+    }
+    if (s->nb_jobs) {
+        ret = ctx->internal->execute(ctx, draw_cells, NULL, NULL,
+                                     FFMIN(s->nb_jobs, ff_filter_get_nb_threads(ctx)));
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!(out = av_frame_clone(s->canvas)))
+        return AVERROR(ENOMEM);
+    out->pts = s->next_pts++;
+    return ff_filter_frame(outlink, out);
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    MosaicContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    int64_t newest = AV_NOPTS_VALUE;
+    int i, ret, nb_eof = 0, nb_ready = 0, nb_reached = 0, dirty = 0;
+
+    FF_FILTER_FORWARD_STATUS_BACK_ALL(outlink, ctx);
+
+    /* take the frames due for the next output frame, leave the later ones */
+    for (i = 0; i < s->nb_inputs; i++) {
+        AVFilterLink *inlink = ctx->inputs[i];
+        MosaicInput *in = &s->in[i];
+        int64_t pts;
+        int status;
+
+        while (ff_inlink_queued_frames(inlink)) {
+            AVFrame *frame = ff_inlink_peek_frame(inlink, 0);
+
+            if (frame->pts != AV_NOPTS_VALUE) {
+                in->time = av_rescale_q(frame->pts, inlink->time_base, AV_TIME_BASE_Q);
+                if (s->next_pts == AV_NOPTS_VALUE) {
+                    s->next_pts   = av_rescale_q(frame->pts, inlink->time_base,
+                                                 outlink->time_base);
+                    s->start_time = in->time;
+                }
+                if (av_compare_ts(frame->pts, inlink->time_base,
+                                  s->next_pts, outlink->time_base) > 0)
+                    break;
+            }
+            ret = ff_inlink_consume_frame(inlink, &frame);
+            if (ret < 0)
+                return ret;
+            av_frame_free(&in->frame);
+            in->frame = frame;
+            in->dirty = 1;
+        }
+        if (!in->eof && ff_inlink_acknowledge_status(inlink, &status, &pts))
+            in->eof = 1;
+        if (in->time != AV_NOPTS_VALUE &&
+            (newest == AV_NOPTS_VALUE || in->time > newest))
+            newest = in->time;
+    }
+
+    for (i = 0; i < s->nb_inputs; i++) {
+        MosaicInput *in = &s->in[i];
+        int64_t last = in->time != AV_NOPTS_VALUE ? in->time : s->start_time;
+
+        dirty |= in->dirty;
+        if (in->eof) {
+            nb_eof++;
+            nb_ready++;
+        } else if (ff_inlink_queued_frames(ctx->inputs[i])) {
+            nb_reached++;
+            nb_ready++;
+        } else if (s->timeout && newest != AV_NOPTS_VALUE &&
+                   newest - last > s->timeout) {
+            nb_ready++;
+        }
+    }
+
+    /* an input past the next output time is needed for the time to move */
+    if (nb_reached && (s->sync == SYNC_ANY || nb_ready == s->nb_inputs))
+        return output_frame(ctx);
+
+    if (nb_eof == s->nb_inputs) {
+        if (dirty)
+            return output_frame(ctx);
+        ff_outlink_set_status(outlink, AVERROR_EOF,
+                              s->next_pts == AV_NOPTS_VALUE ? 0 : s->next_pts);
+        return 0;
+    }
+
+    if (ff_outlink_frame_wanted(outlink)) {
+        for (i = 0; i < s->nb_inputs; i++)
+            if (!s->in[i].eof && !ff_inlink_queued_frames(ctx->inputs[i]))
+                ff_inlink_request_frame(ctx->inputs[i]);
+    }
+
+    return FFERROR_NOT_READY;
+}
+
+static const AVFilterPad mosaic_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_mosaic = {
+    .name          = "mosaic",
+    .description   = NULL_IF_CONFIG_SMALL("Scale video inputs and place them on a grid."),
+    .priv_size     = sizeof(MosaicContext),
+    .priv_class    = &mosaic_class,
+    .query_formats = query_formats,
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    .inputs        = NULL,
+    .outputs       = mosaic_outputs,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -0,0 +1,382 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Detect motion against an adaptive background of the downsampled luma,
+ * and export where it happened as frame metadata.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixelutils.h"
+#include "libavutil/pixdesc.h"
+
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+#include "video.h"
+
+#define MAX_SCALE 3
+
+typedef struct MotionPlane {
+    uint8_t *data;
+    int linesize;
+    int w, h;
+} MotionPlane;
+
+typedef struct MotionZone {
+    int x, y, w, h;             ///< zone in input pixels
+    int bx0, by0, bx1, by1;     ///< blocks overlapping the zone, bx1 and by1 excluded
+} MotionZone;
+
+typedef struct MotionDetectContext {
+    const AVClass *class;
+    int scale;                  ///< log2 of the downsampling factor
+    int block_size;             ///< block size in downsampled pixels
+    int threshold;              ///< mean absolute difference of a changed block
+    double learn;               ///< background learning rate
+    char *zones_str;
+
+    av_pixelutils_sad_fn sad;
+
+    MotionPlane levels[MAX_SCALE + 1]; ///< input luma and its downsampled versions
+    uint8_t *levels_buf;
+    uint8_t *bg;                ///< background, as compared to the input
+    uint16_t *bg16;             ///< background with 8 bits of fraction
+    int bg_linesize;
+    int learn_q8;
+    int sad_threshold;
+    uint8_t *mask;              ///< changed blocks
+    int nb_blocks_w, nb_blocks_h;
+    int init;                   ///< background must be set from the next frame
+
+    MotionZone *zones;
+    int nb_zones;
+} MotionDetectContext;
+
+#define OFFSET(x) offsetof(MotionDetectContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption motiondetect_options[] = {
+    { "scale",     "set log2 of the luma downsampling factor", OFFSET(scale), AV_OPT_TYPE_INT, { .i64 = 2 }, 0, MAX_SCALE, FLAGS },
+    { "block",     "set block size in downsampled pixels", OFFSET(block_size), AV_OPT_TYPE_INT, { .i64 = 8 }, 2, 16, FLAGS },
+    { "threshold", "set mean absolute difference for a block to change", OFFSET(threshold), AV_OPT_TYPE_INT, { .i64 = 12 }, 1, 255, FLAGS },
+    { "learn",     "set background learning rate", OFFSET(learn), AV_OPT_TYPE_DOUBLE, { .dbl = 0.02 }, 0, 1, FLAGS },
+    { "zones",     "set zones to report, as WxH+X+Y separated by '|'", OFFSET(zones_str), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(motiondetect);
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    MotionDetectContext *s = ctx->priv;
+    char *p, *saveptr = NULL, *str;
+
+    if (s->block_size & (s->block_size - 1)) {
+        av_log(ctx, AV_LOG_ERROR, "Block size %d is not a power of 2.\n", s->block_size);
+        return AVERROR(EINVAL);
+    }
+    s->sad = av_pixelutils_get_sad_fn(av_log2(s->block_size), av_log2(s->block_size), 0, ctx);
+    if (!s->sad)
+        return AVERROR(EINVAL);
+
+    if (!s->zones_str)
+        return 0;
+    if (!(str = av_strdup(s->zones_str)))
+        return AVERROR(ENOMEM);
+    for (p = av_strtok(str, "|", &saveptr); p; p = av_strtok(NULL, "|", &saveptr)) {
+        MotionZone zone = { 0 };
+
+        if (sscanf(p, "%dx%d+%d+%d", &zone.w, &zone.h, &zone.x, &zone.y) != 4 ||
+            zone.w <= 0 || zone.h <= 0 || zone.x < 0 || zone.y < 0) {
+            av_log(ctx, AV_LOG_ERROR, "Invalid zone '%s'.\n", p);
+            av_free(str);
+            return AVERROR(EINVAL);
+        }
+        if (av_dynarray2_add((void **)&s->zones, &s->nb_zones,
+                             sizeof(zone), (const uint8_t *)&zone) == NULL) {
+            av_free(str);
+            return AVERROR(ENOMEM);
+        }
+    }
+    av_free(str);
+
+    return 0;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    MotionDetectContext *s = ctx->priv;
+
+    av_freep(&s->levels_buf);
+    av_freep(&s->bg);
+    av_freep(&s->bg16);
+    av_freep(&s->mask);
+    av_freep(&s->zones);
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_GRAY8,
+        AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUV411P,
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
+        AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV444P,
+        AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P,
+        AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_YUVJ440P,
+        AV_PIX_FMT_YUVJ444P,
+        AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUVA422P,
+        AV_PIX_FMT_YUVA444P,
+        AV_PIX_FMT_NV12, AV_PIX_FMT_NV21,
+        AV_PIX_FMT_NONE
+    };
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    MotionDetectContext *s = ctx->priv;
+    const int bs = s->block_size, bsz = bs << s->scale;
+    int i, size = 0, bg_w, bg_h;
+    uint8_t *buf;
+
+    av_freep(&s->levels_buf);
+    av_freep(&s->bg);
+    av_freep(&s->bg16);
+    av_freep(&s->mask);
+
+    /* level 0 is the input luma, set for each frame */
+    s->levels[0].w = inlink->w;
+    s->levels[0].h = inlink->h;
+    for (i = 1; i <= s->scale; i++) {
+        s->levels[i].w        = s->levels[i - 1].w >> 1;
+        s->levels[i].h        = s->levels[i - 1].h >> 1;
+        s->levels[i].linesize = FFALIGN(s->levels[i].w, 32);
+        size += s->levels[i].linesize * s->levels[i].h;
+    }
+
+    s->nb_blocks_w = s->levels[s->scale].w / bs;
+    s->nb_blocks_h = s->levels[s->scale].h / bs;
+    if (!s->nb_blocks_w || !s->nb_blocks_h) {
+        av_log(ctx, AV_LOG_ERROR, "Input %dx%d too small for %d pixel blocks.\n",
+               inlink->w, inlink->h, bsz);
+        return AVERROR(EINVAL);
+    }
+    bg_w = s->nb_blocks_w * bs;
+    bg_h = s->nb_blocks_h * bs;
+    s->bg_linesize = FFALIGN(bg_w, 32);
+
+    if (size && !(s->levels_buf = av_malloc(size)))
+        return AVERROR(ENOMEM);
+    for (buf = s->levels_buf, i = 1; i <= s->scale; i++) {
+        s->levels[i].data = buf;
+        buf += s->levels[i].linesize * s->levels[i].h;
+    }
+
+    s->bg   = av_malloc_array(s->bg_linesize, bg_h);
+    s->bg16 = av_malloc_array(s->bg_linesize, bg_h * sizeof(*s->bg16));
+    s->mask = av_malloc_array(s->nb_blocks_w, s->nb_blocks_h);
+    if (!s->bg || !s->bg16 || !s->mask)
+        return AVERROR(ENOMEM);
+
+    s->learn_q8      = lrint(s->learn * 256);
+    s->sad_threshold = s->threshold * bs * bs;
+    s->init          = 1;
+
+    for (i = 0; i < s->nb_zones; i++) {
+        MotionZone *zone = &s->zones[i];
+
+        zone->bx0 = FFMIN(zone->x / bsz, s->nb_blocks_w);
+        zone->by0 = FFMIN(zone->y / bsz, s->nb_blocks_h);
+        zone->bx1 = FFMIN((zone->x + zone->w + bsz - 1) / bsz, s->nb_blocks_w);
+        zone->by1 = FFMIN((zone->y + zone->h + bsz - 1) / bsz, s->nb_blocks_h);
+        if (zone->bx0 >= zone->bx1 || zone->by0 >= zone->by1)
+            av_log(ctx, AV_LOG_WARNING, "Zone %d is outside of the detection area.\n", i);
+    }
+
+    return 0;
+}
+
+static int downsample(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    const MotionPlane *dst = arg;
+    const MotionPlane *src = dst - 1;
+    const int start = (dst->h *  jobnr     ) / nb_jobs;
+    const int end   = (dst->h * (jobnr + 1)) / nb_jobs;
+    int x, y;
+
+    for (y = start; y < end; y++) {
+        uint8_t *d = dst->data + y * dst->linesize;
+        const uint8_t *p  = src->data + 2 * y * src->linesize;
+        const uint8_t *p2 = p + src->linesize;
+
+        for (x = 0; x < dst->w; x++)
+            d[x] = (p[2 * x] + p[2 * x + 1] + p2[2 * x] + p2[2 * x + 1] + 2) >> 2;
+    }
+
+    return 0;
+}
+
+static int detect(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MotionDetectContext *s = ctx->priv;
+    const MotionPlane *cur = &s->levels[s->scale];
+    const int bs = s->block_size;
+    const int start = (s->nb_blocks_h *  jobnr     ) / nb_jobs;
+    const int end   = (s->nb_blocks_h * (jobnr + 1)) / nb_jobs;
+    int bx, by, x, y;
+
+    for (by = start; by < end; by++) {
+        for (bx = 0; bx < s->nb_blocks_w; bx++) {
+            const uint8_t *c = cur->data + by * bs * cur->linesize + bx * bs;
+            uint8_t *b       = s->bg   + by * bs * s->bg_linesize  + bx * bs;
+            uint16_t *b16    = s->bg16 + by * bs * s->bg_linesize  + bx * bs;
+
+            if (s->init) {
+                for (y = 0; y < bs; y++) {
+                    for (x = 0; x < bs; x++) {
+                        b[x]   = c[x];
+                        b16[x] = c[x] << 8;
+                    }
+                    c   += cur->linesize;
+                    b   += s->bg_linesize;
+                    b16 += s->bg_linesize;
+                }
+                s->mask[by * s->nb_blocks_w + bx] = 0;
+                continue;
+            }
+
+            s->mask[by * s->nb_blocks_w + bx] =
+                s->sad(c, cur->linesize, b, s->bg_linesize) > s->sad_threshold;
+
+            /* running average, the 8 bit copy is what the next frame is
+             * compared against */
+            for (y = 0; y < bs; y++) {
+                for (x = 0; x < bs; x++) {
+                    int v = b16[x] + ((((c[x] << 8) - b16[x]) * s->learn_q8 + 128) >> 8);
+                    b16[x] = v;
+                    b[x]   = (v + 128) >> 8;
+                }
+                c   += cur->linesize;
+                b   += s->bg_linesize;
+                b16 += s->bg_linesize;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void set_meta_double(AVDictionary **metadata, const char *key, double d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), "%f", d);
+    av_dict_set(metadata, key, value, 0);
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    MotionDetectContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    const int bsz = s->block_size << s->scale;
+    int i, bx, by, count = 0;
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = -1, y1 = -1;
+    char key[128];
+
+    s->levels[0].data     = frame->data[0];
+    s->levels[0].linesize = frame->linesize[0];
+    for (i = 1; i <= s->scale; i++)
+        ctx->internal->execute(ctx, downsample, &s->levels[i], NULL,
+                               FFMIN(s->levels[i].h, nb_threads));
+    ctx->internal->execute(ctx, detect, NULL, NULL,
+                           FFMIN(s->nb_blocks_h, nb_threads));
+    s->init = 0;
+
+    for (by = 0; by < s->nb_blocks_h; by++) {
+        for (bx = 0; bx < s->nb_blocks_w; bx++) {
+            if (!s->mask[by * s->nb_blocks_w + bx])
+                continue;
+            count++;
+            x0 = FFMIN(x0, bx);
+            y0 = FFMIN(y0, by);
+            x1 = FFMAX(x1, bx);
+            y1 = FFMAX(y1, by);
+        }
+    }
+
+    set_meta_double(&frame->metadata, "lavfi.motiondetect.score",
+                    count / (double)(s->nb_blocks_w * s->nb_blocks_h));
+    av_dict_set_int(&frame->metadata, "lavfi.motiondetect.blocks", count, 0);
+    if (count) {
+        av_dict_set_int(&frame->metadata, "lavfi.motiondetect.x", x0 * bsz, 0);
+        av_dict_set_int(&frame->metadata, "lavfi.motiondetect.y", y0 * bsz, 0);
+        av_dict_set_int(&frame->metadata, "lavfi.motiondetect.w", (x1 + 1 - x0) * bsz, 0);
+        av_dict_set_int(&frame->metadata, "lavfi.motiondetect.h", (y1 + 1 - y0) * bsz, 0);
+    }
+
+    for (i = 0; i < s->nb_zones; i++) {
+        const MotionZone *zone = &s->zones[i];
+        int nb = (zone->bx1 - zone->bx0) * (zone->by1 - zone->by0), changed = 0;
+
+        for (by = zone->by0; by < zone->by1; by++)
+            for (bx = zone->bx0; bx < zone->bx1; bx++)
+                changed += s->mask[by * s->nb_blocks_w + bx];
+        snprintf(key, sizeof(key), "lavfi.motiondetect.zone.%d", i);
+        set_meta_double(&frame->metadata, key, nb > 0 ? changed / (double)nb : 0);
+    }
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+static const AVFilterPad motiondetect_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
+        .filter_frame = filter_frame,
+    },
+    { NULL }
+};
+
+static const AVFilterPad motiondetect_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_motiondetect = {
+    .name          = "motiondetect",
+    .description   = NULL_IF_CONFIG_SMALL("Detect motion against an adaptive background."),
+    .priv_size     = sizeof(MotionDetectContext),
+    .priv_class    = &motiondetect_class,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .inputs        = motiondetect_inputs,
+    .outputs       = motiondetect_outputs,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -32,6 +32,7 @@
 #include "libavutil/error.h"
 #include "libavutil/fifo.h"
 #include "libavutil/log.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/thread.h"
 #include "url.h"
@@ -78,6 +79,10 @@ typedef struct Context {
 
     int             abort_request;
     AVIOInterruptCB interrupt_callback;
+
+    char           *mem_account_name;
+    AVMemAccount   *mem_account;
+    int64_t         mem_charged;
 } Context;
 
 static int ring_init(RingBuffer *ring, unsigned int capacity, int read_back_capacity)
@@ -241,13 +246,33 @@ static int async_open(URLContext *h, const char *arg, int flags, AVDictionary **
 {
     Context         *c = h->priv_data;
     int              ret;
+    int              shrink = 0;
     AVIOInterruptCB  interrupt_callback = {.callback = async_check_interrupt, .opaque = h};
 
     av_strstart(arg, "async:", &arg);
 
-    ret = ring_init(&c->ring, BUFFER_CAPACITY, READ_BACK_CAPACITY);
+    if (c->mem_account_name) {
+        AVMemAccount *parent = av_mem_account_find(c->mem_account_name);
+
+        if (!parent) {
+            av_log(h, AV_LOG_ERROR, "Memory account '%s' not found\n",
+                   c->mem_account_name);
+            return AVERROR(EINVAL);
+        }
+        ret = av_mem_account_alloc(&c->mem_account, NULL, h, parent);
+        av_mem_account_unref(&parent);
+        if (ret < 0)
+            return ret;
+        /* buffer less when the session already holds too much memory */
+        if (av_mem_account_over_budget(c->mem_account))
+            shrink = 3;
+    }
+
+    ret = ring_init(&c->ring, BUFFER_CAPACITY >> shrink, READ_BACK_CAPACITY >> shrink);
     if (ret < 0)
         goto fifo_fail;
+    c->mem_charged = (BUFFER_CAPACITY + READ_BACK_CAPACITY) >> shrink;
+    av_mem_account_add(c->mem_account, c->mem_charged);
 
     /* wrap interrupt callback */
     c->interrupt_callback = h->interrupt_callback;
@@ -296,7 +321,9 @@ mutex_fail:
     ffurl_close(c->inner);
 url_fail:
     ring_destroy(&c->ring);
+    av_mem_account_add(c->mem_account, -c->mem_charged);
 fifo_fail:
+    av_mem_account_unref(&c->mem_account);
     return ret;
 }
 
@@ -319,6 +346,8 @@ static int async_close(URLContext *h)
     pthread_mutex_destroy(&c->mutex);
     ffurl_close(c->inner);
     ring_destroy(&c->ring);
+    av_mem_account_add(c->mem_account, -c->mem_charged);
+    av_mem_account_unref(&c->mem_account);
 
     return 0;
 }
@@ -466,6 +495,7 @@ static int64_t async_seek(URLContext *h, int64_t pos, int whence)
 #define D AV_OPT_FLAG_DECODING_PARAM
 
 static const AVOption options[] = {
+    { "mem_account", "name of the memory account the buffer is attributed to", OFFSET(mem_account_name), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, D },
     {NULL},
 };
 
@@ -1479,6 +1479,7 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_FAST_SEEK   0x80000 ///< Enable fast, but inaccurate seeks for some formats
 #define AVFMT_FLAG_SHORTEST   0x100000 ///< Stop muxing when the shortest stream stops.
 #define AVFMT_FLAG_AUTO_BSF   0x200000 ///< Wait for packet data before writing a header, and add bitstream filters as requested by the muxer
+#define AVFMT_FLAG_KEYFRAMES_ONLY 0x400000 ///< Drop the non-keyframes of streams discarded with AVDISCARD_NONKEY, also those only known as such to the demuxer or a parser
 
     /**
      * Maximum size of the data read from input for determining
@@ -20,6 +20,7 @@
  */
 
 #include "libavutil/avassert.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/time.h"
 #include "libavutil/thread.h"
@@ -78,6 +79,10 @@ typedef struct FifoContext {
     /* Value > 0 signals queue overflow */
     volatile uint8_t overflow_flag;
 
+    /* Name of the account the queued packets are attributed to */
+    char *mem_account_name;
+    AVMemAccount *mem_account;
+
 } FifoContext;
 
 typedef struct FifoThreadContext {
@@ -110,6 +115,8 @@ typedef enum FifoMessageType {
 typedef struct FifoMessage {
     FifoMessageType type;
     AVPacket pkt;
+    /* Account charged with the packet size while it is queued */
+    AVMemAccount *mem_account;
 } FifoMessage;
 
 static int fifo_thread_write_header(FifoThreadContext *ctx)
@@ -253,8 +260,10 @@ static void free_message(void *msg)
 {
     FifoMessage *fifo_msg = msg;
 
-    if (fifo_msg->type == FIFO_WRITE_PACKET)
+    if (fifo_msg->type == FIFO_WRITE_PACKET) {
+        av_mem_account_add(fifo_msg->mem_account, -fifo_msg->pkt.size);
         av_packet_unref(&fifo_msg->pkt);
+    }
 }
 
 static int fifo_thread_process_recovery_failure(FifoThreadContext *ctx, AVPacket *pkt,
@@ -435,6 +444,13 @@ static void *fifo_consumer_thread(void *data)
             av_thread_message_queue_set_err_send(queue, ret);
             break;
         }
+        /* Uncharge the packet once it has left the queue; the account is
+         * cleared so that freeing the message after a failed recovery does
+         * not uncharge it a second time. */
+        if (msg.type == FIFO_WRITE_PACKET) {
+            av_mem_account_add(msg.mem_account, -msg.pkt.size);
+            msg.mem_account = NULL;
+        }
     }
 
     fifo->write_trailer_ret = fifo_thread_write_trailer(&fifo_thread_ctx);
@@ -506,6 +522,20 @@ static int fifo_init(AVFormatContext *avf)
         return ret;
     }
 
+    if (fifo->mem_account_name) {
+        AVMemAccount *parent = av_mem_account_find(fifo->mem_account_name);
+
+        if (!parent) {
+            av_log(avf, AV_LOG_ERROR, "Memory account '%s' not found\n",
+                   fifo->mem_account_name);
+            return AVERROR(EINVAL);
+        }
+        ret = av_mem_account_alloc(&fifo->mem_account, NULL, avf, parent);
+        av_mem_account_unref(&parent);
+        if (ret < 0)
+            return ret;
+    }
+
     ret = fifo_mux_init(avf, oformat, avf->filename);
     if (ret < 0)
         return ret;
@@ -551,11 +581,21 @@ static int fifo_write_packet(AVFormatContext *avf, AVPacket *pkt)
         ret = av_packet_ref(&msg.pkt,pkt);
         if (ret < 0)
             return ret;
+        msg.mem_account = fifo->mem_account;
     }
 
-    ret = av_thread_message_queue_send(fifo->queue, &msg,
-                                       fifo->drop_pkts_on_overflow ?
-                                       AV_THREAD_MESSAGE_NONBLOCK : 0);
+    if (pkt && fifo->drop_pkts_on_overflow &&
+        av_mem_account_over_budget(fifo->mem_account)) {
+        /* shed the queued packets as on a queue overflow */
+        ret = AVERROR(EAGAIN);
+    } else {
+        av_mem_account_add(msg.mem_account, msg.pkt.size);
+        ret = av_thread_message_queue_send(fifo->queue, &msg,
+                                           fifo->drop_pkts_on_overflow ?
+                                           AV_THREAD_MESSAGE_NONBLOCK : 0);
+        if (ret < 0)
+            av_mem_account_add(msg.mem_account, -msg.pkt.size);
+    }
     if (ret == AVERROR(EAGAIN)) {
         uint8_t overflow_set = 0;
 
@@ -609,6 +649,7 @@ static void fifo_deinit(AVFormatContext *avf)
     av_thread_message_queue_free(&fifo->queue);
     if (fifo->overflow_flag_lock_initialized)
         pthread_mutex_destroy(&fifo->overflow_flag_lock);
+    av_mem_account_unref(&fifo->mem_account);
 }
 
 #define OFFSET(x) offsetof(FifoContext, x)
@@ -643,6 +684,9 @@ static const AVOption options[] = {
         {"recover_any_error", "Attempt recovery regardless of type of the error", OFFSET(recover_any_error),
          AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
 
+        {"mem_account", "Name of the memory account the queued packets are attributed to", OFFSET(mem_account_name),
+         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM},
+
         {NULL},
 };
 
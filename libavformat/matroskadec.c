@@ -3326,6 +3326,11 @@ static int matroska_parse_block(MatroskaDemuxContext *matroska, uint8_t *data,
         }
     }
 
+    /* the block has been indexed above, the payload is not needed */
+    if ((matroska->ctx->flags & AVFMT_FLAG_KEYFRAMES_ONLY) &&
+        st->discard >= AVDISCARD_NONKEY && !is_keyframe)
+        return res;
+
     res = matroska_parse_laces(matroska, &data, &size, (flags & 0x06) >> 1,
                                &lace_size, &laces);
 
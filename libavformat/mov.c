@@ -6514,7 +6514,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     AVIndexEntry *sample;
     AVStream *st = NULL;
     int64_t current_index;
-    int ret;
+    int ret, discard;
     mov->fc = s;
  retry:
     sample = mov_find_next_sample(s, &st);
@@ -6535,7 +6535,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         sample->size = FFMIN(sample->size, (mov->next_root_atom - sample->pos));
     }
 
-    if (st->discard != AVDISCARD_ALL) {
+    /* Discarded samples are neither seeked to nor read, but still go
+     * through the timestamp bookkeeping below so that ctts stays in sync. */
+    discard = st->discard == AVDISCARD_ALL ||
+              (st->discard >= AVDISCARD_NONKEY && !(sample->flags & AVINDEX_KEYFRAME));
+
+    if (!discard) {
         int64_t ret64 = avio_seek(sc->pb, sample->pos, SEEK_SET);
         if (ret64 != sample->pos) {
             av_log(mov->fc, AV_LOG_ERROR, "stream %d, offset 0x%"PRIx64": partial file\n",
@@ -6546,11 +6551,6 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             return AVERROR_INVALIDDATA;
         }
 
-        if( st->discard == AVDISCARD_NONKEY && 0==(sample->flags & AVINDEX_KEYFRAME) ) {
-            av_log(mov->fc, AV_LOG_DEBUG, "Nonkey frame from stream %d discarded due to AVDISCARD_NONKEY\n", sc->ffindex);
-            goto retry;
-        }
-
         ret = av_get_packet(sc->pb, pkt, sample->size);
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
@@ -6605,7 +6605,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         pkt->duration = next_dts - pkt->dts;
         pkt->pts = pkt->dts;
     }
-    if (st->discard == AVDISCARD_ALL)
+    if (discard)
         goto retry;
     pkt->flags |= sample->flags & AVINDEX_KEYFRAME ? AV_PKT_FLAG_KEY : 0;
     pkt->pos = sample->pos;
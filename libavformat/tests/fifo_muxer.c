@@ -340,6 +340,71 @@ fail:
     return ret;
 }
 
+static int fifo_write_packet_err_mem_tst(AVFormatContext *oc, AVDictionary **opts,
+                                         const FailingMuxerPacketData *pkt_data)
+{
+    AVMemAccount *acc = av_mem_account_find("fifo-acc");
+    int64_t usage;
+    int ret = 0, i;
+    AVPacket pkt;
+
+    av_init_packet(&pkt);
+
+    if (!acc)
+        return AVERROR_BUG;
+
+    ret = avformat_write_header(oc, opts);
+    if (ret) {
+        fprintf(stderr, "Unexpected write_header failure: %s\n",
+                av_err2str(ret));
+        goto fail;
+    }
+
+    ret = prepare_packet(&pkt, pkt_data, 0);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to prepare test packet: %s\n",
+                av_err2str(ret));
+        goto write_trailer_and_fail;
+    }
+    ret = av_write_frame(oc, &pkt);
+    av_packet_unref(&pkt);
+    if (ret < 0) {
+        fprintf(stderr, "Unexpected write_frame error: %s\n", av_err2str(ret));
+        goto write_trailer_and_fail;
+    }
+
+    /* Flushes are not charged to the account; send them until the error of
+     * the only packet is reported, which happens after it has been freed. */
+    for (i = 0; i < MAX_TST_PACKETS && !ret; i++)
+        ret = av_write_frame(oc, NULL);
+
+    if (ret != -1) {
+        fprintf(stderr, "Unexpected write_packet result: %s\n", av_err2str(ret));
+        ret = AVERROR_BUG;
+        goto write_trailer_and_fail;
+    }
+
+    av_mem_account_get_usage(acc, &usage, NULL);
+    if (usage) {
+        fprintf(stderr, "Memory account usage %"PRId64" after the failed packet\n",
+                usage);
+        ret = AVERROR_BUG;
+        goto write_trailer_and_fail;
+    }
+
+    av_mem_account_unref(&acc);
+    ret = av_write_trailer(oc);
+    if (ret < 0)
+        fprintf(stderr, "Unexpected write_trailer error: %s\n", av_err2str(ret));
+
+    return ret;
+write_trailer_and_fail:
+    av_write_trailer(oc);
+fail:
+    av_mem_account_unref(&acc);
+    return ret;
+}
+
 typedef struct TestCase {
     int (*test_func)(AVFormatContext *, AVDictionary **,const FailingMuxerPacketData *pkt_data);
     const char *test_name;
@@ -427,21 +492,51 @@ const TestCase tests[] = {
         {fifo_overflow_drop_test, "overflow with packet dropping", "queue_size=3:drop_pkts_on_overflow=1",
          0, 0, 0, {0, 0, SLEEPTIME_50_MS}},
 
+        /* The queued packets are attributed to a memory account. */
+        {fifo_basic_test, "memory accounting", "mem_account=fifo-acc",
+         1, 0, 0, {0, 0, 0}},
+
+        /* The memory account is over budget from the start, so every packet
+         * should be dropped. */
+        {fifo_overflow_drop_test, "packet dropping over memory budget",
+         "drop_pkts_on_overflow=1:mem_account=fifo-budget",
+         1, 0, 0, {0, 0, 0}},
+
+        /* write_packet fails with an error which is not recovered from; the
+         * failed packet must be uncharged only once. */
+        {fifo_write_packet_err_mem_tst, "write packet error with memory accounting",
+         "mem_account=fifo-acc", 0, 0, 0, {-1, MAX_TST_PACKETS, 0}},
+
         {NULL}
 };
 
 int main(int argc, char *argv[])
 {
+    AVMemAccount *acc, *budget;
+    int64_t acc_usage, budget_usage;
     int i, ret, ret_all = 0;
 
     av_register_all();
     av_register_output_format(&tst_failing_muxer);
 
+    if (av_mem_account_alloc(&acc, "fifo-acc", NULL, NULL) < 0 ||
+        av_mem_account_alloc(&budget, "fifo-budget", NULL, NULL) < 0)
+        return 1;
+    av_mem_account_set_budget(budget, 1, NULL, NULL);
+    av_mem_account_add(budget, 2);
+
     for (i = 0; tests[i].test_func; i++) {
         ret = run_test(&tests[i]);
         if (!ret_all && ret < 0)
             ret_all = ret;
     }
 
+    av_mem_account_get_usage(acc, &acc_usage, NULL);
+    av_mem_account_get_usage(budget, &budget_usage, NULL);
+    printf("memory accounts balanced: %s\n",
+           !acc_usage && budget_usage == 2 ? "yes" : "no");
+    av_mem_account_unref(&acc);
+    av_mem_account_unref(&budget);
+
     return ret;
 }
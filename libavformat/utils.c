@@ -1479,6 +1479,16 @@ static int parse_packet(AVFormatContext *s, AVPacket *pkt, int stream_index)
 
         compute_pkt_fields(s, st, st->parser, &out_pkt, next_dts, next_pts);
 
+        /* Demuxers without a keyframe index cannot honour AVDISCARD_NONKEY
+         * themselves, but the parser knows which frames are keyframes. */
+        if ((s->flags & AVFMT_FLAG_KEYFRAMES_ONLY) &&
+            st->discard >= AVDISCARD_NONKEY &&
+            st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+            !(out_pkt.flags & AV_PKT_FLAG_KEY)) {
+            av_packet_unref(&out_pkt);
+            continue;
+        }
+
         ret = add_to_pktbuf(&s->internal->parse_queue, &out_pkt,
                             &s->internal->parse_queue_end, 1);
         av_packet_unref(&out_pkt);
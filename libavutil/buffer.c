@@ -231,6 +231,7 @@ AVBufferPool *av_buffer_pool_init2(int size, void *opaque,
     pool->pool_free = pool_free;
 
     atomic_init(&pool->refcount, 1);
+    atomic_init(&pool->pool, 0);
 
     return pool;
 }
@@ -247,6 +248,7 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
 
     atomic_init(&pool->refcount, 1);
+    atomic_init(&pool->pool, 0);
 
     return pool;
 }
@@ -257,9 +259,11 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    BufferPoolEntry *next = (BufferPoolEntry *)atomic_load(&pool->pool);
+
+    while (next) {
+        BufferPoolEntry *buf = next;
+        next = buf->next;
 
         buf->free(buf->opaque, buf->data);
         av_freep(&buf);
@@ -285,6 +289,27 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
         buffer_pool_free(pool);
 }
 
+/* push the list of entries starting at first on the stack of unused ones */
+static void pool_push(AVBufferPool *pool, BufferPoolEntry *first)
+{
+    BufferPoolEntry *last = first;
+    intptr_t head = 0;
+
+    /* the stack is usually still empty after av_buffer_pool_get() took it */
+    if (atomic_compare_exchange_strong_explicit(&pool->pool, &head, (intptr_t)first,
+                                                memory_order_release,
+                                                memory_order_relaxed))
+        return;
+
+    while (last->next)
+        last = last->next;
+    do {
+        last->next = (BufferPoolEntry *)head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->pool, &head, (intptr_t)first,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
 static void pool_release_buffer(void *opaque, uint8_t *data)
 {
     BufferPoolEntry *buf = opaque;
@@ -293,10 +318,8 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     if(CONFIG_MEMORY_POISONING)
         memset(buf->data, FF_MEMORY_POISON, pool->size);
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    buf->next = NULL;
+    pool_push(pool, buf);
 
     if (atomic_fetch_add_explicit(&pool->refcount, -1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -336,19 +359,25 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     AVBufferRef *ret;
     BufferPoolEntry *buf;
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    /* Take the whole stack and put back all but its top entry. A concurrent
+     * caller may find it empty meanwhile and allocate a new buffer, which
+     * only makes the pool slightly larger. */
+    buf = (BufferPoolEntry *)atomic_exchange_explicit(&pool->pool, 0,
+                                                      memory_order_acquire);
     if (buf) {
+        if (buf->next)
+            pool_push(pool, buf->next);
+        buf->next = NULL;
+
         ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                                buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
-        }
+        if (!ret)
+            pool_push(pool, buf);
     } else {
+        ff_mutex_lock(&pool->mutex);
         ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&pool->mutex);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
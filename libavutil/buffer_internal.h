@@ -74,8 +74,17 @@ typedef struct BufferPoolEntry {
 } BufferPoolEntry;
 
 struct AVBufferPool {
+    /**
+     * Serializes the calls to alloc/alloc2, which some callers rely on.
+     */
     AVMutex mutex;
-    BufferPoolEntry *pool;
+
+    /**
+     * The BufferPoolEntry on top of the lock-free stack of unused buffers.
+     * Entries are only taken off it all at once with an atomic exchange, so
+     * a compare-and-swap never acts on a stale next pointer (ABA problem).
+     */
+    atomic_intptr_t pool;
 
     /*
      * This is used to track when the pool is to be freed.
@@ -27,9 +27,18 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/* number of entries from which exact key lookups go through a hash index */
+#define DICT_HASH_MIN_COUNT 16
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    /* Open addressing table of element indexes + 1, 0 for an empty slot.
+     * Keys are hashed in upper case so that the table serves both the case
+     * sensitive and insensitive lookups. NULL below DICT_HASH_MIN_COUNT
+     * entries, or if allocating it failed. */
+    unsigned *hash;
+    unsigned hash_mask;
 };
 
 int av_dict_count(const AVDictionary *m)
@@ -37,6 +46,91 @@ int av_dict_count(const AVDictionary *m)
     return m ? m->count : 0;
 }
 
+static unsigned hash_key(const char *key)
+{
+    unsigned h = 2166136261U;
+
+    for (; *key; key++)
+        h = (h ^ av_toupper(*key)) * 16777619U;
+    return h;
+}
+
+static void hash_insert(AVDictionary *m, int idx)
+{
+    unsigned i = hash_key(m->elems[idx].key) & m->hash_mask;
+
+    while (m->hash[i])
+        i = (i + 1) & m->hash_mask;
+    m->hash[i] = idx + 1;
+}
+
+static unsigned hash_find_slot(const AVDictionary *m, int idx)
+{
+    unsigned i = hash_key(m->elems[idx].key) & m->hash_mask;
+
+    while (m->hash[i] != idx + 1)
+        i = (i + 1) & m->hash_mask;
+    return i;
+}
+
+static void hash_remove(AVDictionary *m, int idx)
+{
+    unsigned i = hash_find_slot(m, idx), j = i;
+
+    m->hash[i] = 0;
+    /* move back the following entries of the cluster which can no longer
+     * be reached from their home slot */
+    for (;;) {
+        unsigned home;
+
+        j = (j + 1) & m->hash_mask;
+        if (!m->hash[j])
+            break;
+        home = hash_key(m->elems[m->hash[j] - 1].key) & m->hash_mask;
+        if (i <= j ? i < home && home <= j : i < home || home <= j)
+            continue;
+        m->hash[i] = m->hash[j];
+        m->hash[j] = 0;
+        i = j;
+    }
+}
+
+/* (re)build the index with room for twice the number of entries */
+static void hash_build(AVDictionary *m)
+{
+    unsigned size = 2 * DICT_HASH_MIN_COUNT;
+    int i;
+
+    while (size < 2U * m->count)
+        size <<= 1;
+    av_freep(&m->hash);
+    if (!(m->hash = av_calloc(size, sizeof(*m->hash))))
+        return;
+    m->hash_mask = size - 1;
+    for (i = 0; i < m->count; i++)
+        hash_insert(m, i);
+}
+
+static AVDictionaryEntry *hash_get(const AVDictionary *m, const char *key,
+                                   int flags)
+{
+    AVDictionaryEntry *first = NULL;
+    unsigned i;
+
+    /* the keys can be duplicated with AV_DICT_MULTIKEY, and the first one
+     * is returned as with a linear search */
+    for (i = hash_key(key) & m->hash_mask; m->hash[i]; i = (i + 1) & m->hash_mask) {
+        AVDictionaryEntry *e = &m->elems[m->hash[i] - 1];
+
+        if (first && e > first)
+            continue;
+        if (flags & AV_DICT_MATCH_CASE ? !strcmp(e->key, key)
+                                       : !av_strcasecmp(e->key, key))
+            first = e;
+    }
+    return first;
+}
+
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
@@ -45,6 +139,9 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     if (!m)
         return NULL;
 
+    if (m->hash && !prev && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return hash_get(m, key, flags);
+
     if (prev)
         i = prev - m->elems + 1;
     else
@@ -96,6 +193,11 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_free(copy_value);
             return 0;
         }
+        if (m->hash) {
+            hash_remove(m, tag - m->elems);
+            if (tag != &m->elems[m->count - 1])
+                m->hash[hash_find_slot(m, m->count - 1)] = tag - m->elems + 1;
+        }
         if (flags & AV_DICT_APPEND)
             oldval = tag->value;
         else
@@ -124,11 +226,16 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        if (m->hash && 2U * m->count <= m->hash_mask + 1)
+            hash_insert(m, m->count - 1);
+        else if (m->count >= DICT_HASH_MIN_COUNT)
+            hash_build(m);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
         av_freep(&m->elems);
+        av_freep(&m->hash);
         av_freep(pm);
     }
 
@@ -137,6 +244,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 err_out:
     if (m && !m->count) {
         av_freep(&m->elems);
+        av_freep(&m->hash);
         av_freep(pm);
     }
     av_free(copy_key);
@@ -210,6 +318,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].value);
         }
         av_freep(&m->elems);
+        av_freep(&m->hash);
     }
     av_freep(pm);
 }
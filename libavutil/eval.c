@@ -158,16 +158,36 @@ struct AVExpr {
         e_if, e_ifnot, e_print, e_bitand, e_bitor, e_between, e_clip, e_atan2, e_lerp,
     } type;
     double value; // is sign in other types
+    int const_index; // also the index of func1 and func2 functions
     union {
-        int const_index;
         double (*func0)(double);
         double (*func1)(void *, double);
         double (*func2)(void *, double, double);
     } a;
     struct AVExpr *param[3];
     double *var;
+    struct ExprProgram *prog;
 };
 
+#define EXPR_BATCH    32
+#define EXPR_MAX_REGS 32
+
+/**
+ * One instruction of a compiled expression: evaluate the node e with its
+ * parameters already in the registers reg, reg + 1 and reg + 2, and write
+ * its result to register reg.
+ */
+typedef struct ExprInsn {
+    const AVExpr *e;
+    int reg;
+} ExprInsn;
+
+typedef struct ExprProgram {
+    int nb_consts;      ///< highest constant index used + 1
+    ExprInsn *insns;    ///< NULL if the expression could not be compiled
+    int nb_insns;
+} ExprProgram;
+
 static double etime(double v)
 {
     return av_gettime() * 0.000001;
@@ -177,7 +197,7 @@ static double eval_expr(Parser *p, AVExpr *e)
 {
     switch (e->type) {
         case e_value:  return e->value;
-        case e_const:  return e->value * p->const_values[e->a.const_index];
+        case e_const:  return e->value * p->const_values[e->const_index];
         case e_func0:  return e->value * e->a.func0(eval_expr(p, e->param[0]));
         case e_func1:  return e->value * e->a.func1(p->opaque, eval_expr(p, e->param[0]));
         case e_func2:  return e->value * e->a.func2(p->opaque, eval_expr(p, e->param[0]), eval_expr(p, e->param[1]));
@@ -331,6 +351,9 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    if (e->prog)
+        av_freep(&e->prog->insns);
+    av_freep(&e->prog);
     av_freep(&e);
 }
 
@@ -358,7 +381,7 @@ static int parse_primary(AVExpr **e, Parser *p)
         if (strmatch(p->s, p->const_names[i])) {
             p->s+= strlen(p->const_names[i]);
             d->type = e_const;
-            d->a.const_index = i;
+            d->const_index = i;
             *e = d;
             return 0;
         }
@@ -467,6 +490,7 @@ static int parse_primary(AVExpr **e, Parser *p)
         for (i=0; p->func1_names && p->func1_names[i]; i++) {
             if (strmatch(next, p->func1_names[i])) {
                 d->a.func1 = p->funcs1[i];
+                d->const_index = i;
                 d->type = e_func1;
                 *e = d;
                 return 0;
@@ -476,6 +500,7 @@ static int parse_primary(AVExpr **e, Parser *p)
         for (i=0; p->func2_names && p->func2_names[i]; i++) {
             if (strmatch(next, p->func2_names[i])) {
                 d->a.func2 = p->funcs2[i];
+                d->const_index = i;
                 d->type = e_func2;
                 *e = d;
                 return 0;
@@ -669,6 +694,132 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+static int is_foldable(const AVExpr *e)
+{
+    switch (e->type) {
+    case e_value:
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        return 0;
+    case e_func0:
+        return e->a.func0 != etime;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Replace all subtrees which only depend on numeric literals by their value.
+ */
+static void fold_constants(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            fold_constants(e->param[i]);
+    if (!is_foldable(e))
+        return;
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && e->param[i]->type != e_value)
+            return;
+
+    e->value = eval_expr(&p, e);
+    e->type  = e_value;
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+}
+
+static int count_nodes(const AVExpr *e)
+{
+    if (!e)
+        return 0;
+    return 1 + count_nodes(e->param[0]) + count_nodes(e->param[1]) + count_nodes(e->param[2]);
+}
+
+static int count_consts(const AVExpr *e)
+{
+    int i, n = e->type == e_const ? e->const_index + 1 : 0;
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            n = FFMAX(n, count_consts(e->param[i]));
+    return n;
+}
+
+static int is_stateless(const AVExpr *e)
+{
+    int i;
+
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        return 0;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return 0;
+        break;
+    default:
+        break;
+    }
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && !is_stateless(e->param[i]))
+            return 0;
+    return 1;
+}
+
+static int compile_expr(ExprProgram *prog, const AVExpr *e, int reg)
+{
+    int i, ret;
+
+    if (reg + 2 >= EXPR_MAX_REGS)
+        return AVERROR(ENOSPC);
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && (ret = compile_expr(prog, e->param[i], reg + i)) < 0)
+            return ret;
+    prog->insns[prog->nb_insns].e   = e;
+    prog->insns[prog->nb_insns].reg = reg;
+    prog->nb_insns++;
+    return 0;
+}
+
+static int compile_program(AVExpr *e)
+{
+    ExprProgram *prog = av_mallocz(sizeof(*prog));
+
+    if (!prog)
+        return AVERROR(ENOMEM);
+    e->prog = prog;
+    prog->nb_consts = count_consts(e);
+    if (!is_stateless(e))
+        return 0;
+
+    prog->insns = av_malloc_array(count_nodes(e), sizeof(*prog->insns));
+    if (!prog->insns)
+        return AVERROR(ENOMEM);
+    /* too deeply nested, fall back to the tree walker */
+    if (compile_expr(prog, e, 0) < 0) {
+        av_freep(&prog->insns);
+        prog->nb_insns = 0;
+    }
+    return 0;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -711,11 +862,14 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_constants(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
         goto end;
     }
+    if ((ret = compile_program(e)) < 0)
+        goto end;
     *expr = e;
     e = NULL;
 end:
@@ -734,6 +888,148 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+static void expr_count(const AVExpr *e, unsigned *counter, int size, int type)
+{
+    int i;
+
+    if (e->type == type && e->const_index < size)
+        counter[e->const_index]++;
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            expr_count(e->param[i], counter, size, type);
+}
+
+int av_expr_count_vars(AVExpr *e, unsigned *counter, int size)
+{
+    if (!e || !counter || size <= 0)
+        return AVERROR(EINVAL);
+    expr_count(e, counter, size, e_const);
+    return 0;
+}
+
+int av_expr_count_func(AVExpr *e, unsigned *counter, int size, int arg)
+{
+    if (!e || !counter || size <= 0 || arg < 1 || arg > 2)
+        return AVERROR(EINVAL);
+    expr_count(e, counter, size, arg == 1 ? e_func1 : e_func2);
+    return 0;
+}
+
+int av_expr_is_stateless(AVExpr *e)
+{
+    return is_stateless(e);
+}
+
+#define BATCH_LOOP(expr) for (i = 0; i < n; i++) d[i] = expr
+
+static void run_program(const ExprProgram *prog, double *res, int n, int offset,
+                        const double *const_values,
+                        const double * const *const_arrays, void *opaque)
+{
+    DECLARE_ALIGNED(32, double, regs)[EXPR_MAX_REGS][EXPR_BATCH];
+    int i, k;
+
+    for (k = 0; k < prog->nb_insns; k++) {
+        const AVExpr *e = prog->insns[k].e;
+        double *d = regs[prog->insns[k].reg];
+        const double *a = d, *b = d + EXPR_BATCH, *c = d + 2 * EXPR_BATCH;
+        const double v = e->value;
+
+        switch (e->type) {
+        case e_value:  BATCH_LOOP(v); break;
+        case e_const: {
+            const double *src = const_arrays ? const_arrays[e->const_index] : NULL;
+            if (src) {
+                src += offset;
+                BATCH_LOOP(v * src[i]);
+            } else {
+                const double x = v * const_values[e->const_index];
+                BATCH_LOOP(x);
+            }
+            break;
+        }
+        case e_func0:  BATCH_LOOP(v * e->a.func0(a[i])); break;
+        case e_func1:  BATCH_LOOP(v * e->a.func1(opaque, a[i])); break;
+        case e_func2:  BATCH_LOOP(v * e->a.func2(opaque, a[i], b[i])); break;
+        case e_squish: BATCH_LOOP(1/(1+exp(4*a[i]))); break;
+        case e_gauss:  BATCH_LOOP(exp(-a[i]*a[i]/2)/sqrt(2*M_PI)); break;
+        case e_isnan:  BATCH_LOOP(v * !!isnan(a[i])); break;
+        case e_isinf:  BATCH_LOOP(v * !!isinf(a[i])); break;
+        case e_floor:  BATCH_LOOP(v * floor(a[i])); break;
+        case e_ceil:   BATCH_LOOP(v * ceil (a[i])); break;
+        case e_trunc:  BATCH_LOOP(v * trunc(a[i])); break;
+        case e_round:  BATCH_LOOP(v * round(a[i])); break;
+        case e_sqrt:   BATCH_LOOP(v * sqrt (a[i])); break;
+        case e_not:    BATCH_LOOP(v * (a[i] == 0)); break;
+        case e_if:
+            if (e->param[2]) BATCH_LOOP(v * (a[i] ? b[i] : c[i]));
+            else             BATCH_LOOP(v * (a[i] ? b[i] : 0));
+            break;
+        case e_ifnot:
+            if (e->param[2]) BATCH_LOOP(v * (!a[i] ? b[i] : c[i]));
+            else             BATCH_LOOP(v * (!a[i] ? b[i] : 0));
+            break;
+        case e_clip:
+            BATCH_LOOP(isnan(b[i]) || isnan(c[i]) || isnan(a[i]) || b[i] > c[i] ?
+                       NAN : v * av_clipd(a[i], b[i], c[i]));
+            break;
+        case e_between: BATCH_LOOP(v * (a[i] >= b[i] && a[i] <= c[i])); break;
+        case e_lerp:   BATCH_LOOP(a[i] + (b[i] - a[i]) * c[i]); break;
+        case e_mod:    BATCH_LOOP(v * (a[i] - floor((!CONFIG_FTRAPV || b[i]) ? a[i] / b[i] : a[i] * INFINITY) * b[i])); break;
+        case e_gcd:    BATCH_LOOP(v * av_gcd(a[i], b[i])); break;
+        case e_max:    BATCH_LOOP(v * (a[i] >  b[i] ? a[i] : b[i])); break;
+        case e_min:    BATCH_LOOP(v * (a[i] <  b[i] ? a[i] : b[i])); break;
+        case e_eq:     BATCH_LOOP(v * (a[i] == b[i] ? 1.0 : 0.0)); break;
+        case e_gt:     BATCH_LOOP(v * (a[i] >  b[i] ? 1.0 : 0.0)); break;
+        case e_gte:    BATCH_LOOP(v * (a[i] >= b[i] ? 1.0 : 0.0)); break;
+        case e_lt:     BATCH_LOOP(v * (a[i] <  b[i] ? 1.0 : 0.0)); break;
+        case e_lte:    BATCH_LOOP(v * (a[i] <= b[i] ? 1.0 : 0.0)); break;
+        case e_pow:    BATCH_LOOP(v * pow(a[i], b[i])); break;
+        case e_mul:    BATCH_LOOP(v * (a[i] * b[i])); break;
+        case e_div:    BATCH_LOOP(v * ((!CONFIG_FTRAPV || b[i]) ? (a[i] / b[i]) : a[i] * INFINITY)); break;
+        case e_add:    BATCH_LOOP(v * (a[i] + b[i])); break;
+        case e_last:   BATCH_LOOP(v * b[i]); break;
+        case e_hypot:  BATCH_LOOP(v * hypot(a[i], b[i])); break;
+        case e_atan2:  BATCH_LOOP(v * atan2(a[i], b[i])); break;
+        case e_bitand: BATCH_LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] & (long int)b[i])); break;
+        case e_bitor:  BATCH_LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] | (long int)b[i])); break;
+        default:       BATCH_LOOP(NAN); break;
+        }
+    }
+    memcpy(res, regs[0], n * sizeof(*res));
+}
+
+int av_expr_eval_batch(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    const ExprProgram *prog = e->prog;
+    double *values;
+    int i, j;
+
+    if (prog->insns) {
+        for (j = 0; j < nb; j += EXPR_BATCH)
+            run_program(prog, res + j, FFMIN(nb - j, EXPR_BATCH), j,
+                        const_values, const_arrays, opaque);
+        return 0;
+    }
+
+    values = av_malloc_array(FFMAX(prog->nb_consts, 1), sizeof(*values));
+    if (!values)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < prog->nb_consts; i++)
+        if (!const_arrays || !const_arrays[i])
+            values[i] = const_values[i];
+    for (j = 0; j < nb; j++) {
+        for (i = 0; i < prog->nb_consts; i++)
+            if (const_arrays && const_arrays[i])
+                values[i] = const_arrays[i][j];
+        res[j] = av_expr_eval(e, values, opaque);
+    }
+    av_free(values);
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -86,6 +86,73 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for a batch of elements, for
+ * example the pixels of a row or the samples of a buffer.
+ *
+ * The result is the same as calling av_expr_eval() nb times, where the
+ * value of the constant i for element j is const_arrays[i][j] if
+ * const_arrays[i] is not NULL and const_values[i] otherwise.
+ *
+ * Expressions which do not use st(), ld(), random(), print(), while(),
+ * taylor() or root() are compiled by av_expr_parse() into a flat register
+ * bytecode which is run on blocks of elements at once, all other ones are
+ * evaluated element by element. When compiled, the functions from funcs1
+ * and funcs2 may be called in a different order than with av_expr_eval()
+ * and also for the branch of if() and ifnot() which is not taken, so they
+ * must not have side effects.
+ *
+ * @param res          array of nb doubles the results are written to
+ * @param nb           number of elements to evaluate
+ * @param const_values array of values for the identifiers from
+ *                     av_expr_parse() const_names, used for the constants
+ *                     which have no entry in const_arrays; may be NULL if
+ *                     all constants have one
+ * @param const_arrays array of per element value arrays, indexed like
+ *                     const_values, each non-NULL entry holding nb values;
+ *                     may be NULL
+ * @param opaque       a pointer which will be passed to all functions from
+ *                     funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_expr_eval_batch(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
+/**
+ * Track the presence of variables and their number of occurrences in a parsed expression
+ *
+ * @param counter a zero-initialized array where the count of each variable will be stored
+ * @param size size of array
+ * @return 0 on success, a negative value indicates that no expression or array was passed
+ * or size was zero
+ */
+int av_expr_count_vars(AVExpr *e, unsigned *counter, int size);
+
+/**
+ * Track the presence of user provided functions and their number of occurrences
+ * in a parsed expression.
+ *
+ * @param counter a zero-initialized array where the count of each function will be stored
+ *                if you passed 5 functions with 2 arguments to av_expr_parse()
+ *                then for arg=2 this will use upto 5 entries.
+ * @param size size of array
+ * @param arg number of arguments the counted functions have
+ * @return 0 on success, a negative value indicates that no expression or array was passed
+ * or size was zero
+ */
+int av_expr_count_func(AVExpr *e, unsigned *counter, int size, int arg);
+
+/**
+ * Check whether a parsed expression keeps state between evaluations.
+ *
+ * @return 0 if the expression uses st(), ld(), random(), print(), while(),
+ *         taylor(), root() or time(), so that its value may depend on
+ *         previous evaluations or on when it is evaluated, or evaluating it
+ *         has side effects, 1 otherwise
+ */
+int av_expr_is_stateless(AVExpr *e);
+
 /**
  * Free a parsed expression previously created with av_expr_parse().
  */
@@ -141,6 +141,13 @@ enum AVFrameSideDataType {
      * metadata key entry "name".
      */
     AV_FRAME_DATA_ICC_PROFILE,
+
+    /**
+     * Load shedding state of a decoder running with a per-frame time budget
+     * (AVCodecContext.decode_deadline). The payload is an AVDecodeLoad
+     * struct.
+     */
+    AV_FRAME_DATA_DECODE_LOAD,
 };
 
 enum AVActiveFormatDescription {
@@ -153,6 +160,35 @@ enum AVActiveFormatDescription {
     AV_AFD_SP_4_3       = 15,
 };
 
+/**
+ * Work skipped by a decoder to keep up with its time budget, in increasing
+ * order. Each level also implies the ones below it.
+ */
+enum AVDecodeLoadLevel {
+    AV_DECODE_LOAD_NORMAL,           ///< everything is decoded
+    AV_DECODE_LOAD_SKIP_LOOP_FILTER, ///< the loop filter is skipped
+    AV_DECODE_LOAD_SKIP_NONREF,      ///< non-reference frames are skipped
+    AV_DECODE_LOAD_KEY_ONLY,         ///< only keyframes are decoded
+};
+
+/**
+ * Payload of AV_FRAME_DATA_DECODE_LOAD.
+ *
+ * sizeof(AVDecodeLoad) is not a part of the public ABI, new fields may be
+ * added to the end with a minor bump.
+ */
+typedef struct AVDecodeLoad {
+    enum AVDecodeLoadLevel level;
+    /**
+     * Smoothed wall clock time spent decoding a packet, in microseconds.
+     */
+    int64_t decode_time;
+    /**
+     * Time budget per packet the decoder adapts to, in microseconds.
+     */
+    int64_t deadline;
+} AVDecodeLoad;
+
 
 /**
  * Structure to hold side data for an AVFrame.
@@ -33,12 +33,17 @@
 #include <io.h>
 #endif
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include "avstring.h"
 #include "avutil.h"
 #include "bprint.h"
 #include "common.h"
 #include "internal.h"
 #include "log.h"
+#include "thread.h"
+#include "threadmessage.h"
+#include "time.h"
 
 #if HAVE_PTHREADS
 #include <pthread.h>
@@ -439,3 +444,274 @@ void avpriv_report_missing_feature(void *avc, const char *msg, ...)
     missing_feature_sample(0, avc, msg, argument_list);
     va_end(argument_list);
 }
+
+#if HAVE_THREADS
+
+#define ASYNC_LOG_QUEUE_SIZE 256
+#define ASYNC_LOG_CONTEXTS    64
+#define ASYNC_LOG_POLL_US  10000
+
+typedef struct AsyncLogMessage {
+    int64_t time;
+    int level;
+    const void *avcl;       ///< only used to tell the contexts apart
+    char prefix[256];
+    char name[64];
+    char text[LINE_SZ];
+} AsyncLogMessage;
+
+/* what the writer thread remembers of a logging context */
+typedef struct AsyncLogContext {
+    int used;
+    AsyncLogMessage last;   ///< last message written
+    int repeated;
+    int64_t window_start;   ///< start of the current second for max_rate
+    int window_count;
+    int suppressed;
+} AsyncLogContext;
+
+static AVThreadMessageQueue *async_log_queue;
+static pthread_t async_log_thread;
+static AsyncLogContext *async_log_contexts;
+static int async_log_flags;
+static int async_log_max_rate;
+static int async_log_line_start;
+static FILE *async_log_file;
+static atomic_int async_log_dropped;
+static void (*async_log_prev_callback)(void*, int, const char*, va_list);
+
+static void async_log_callback(void *avcl, int level, const char *fmt, va_list vl)
+{
+    AVClass *avc = avcl ? *(AVClass **) avcl : NULL;
+    AsyncLogMessage msg;
+    AVBPrint part[4];
+    int print_prefix = 1;
+
+    if (level >= 0)
+        level &= 0xff;
+    if (level > av_log_level)
+        return;
+
+    /* the prefix is always formatted, the writer thread knows whether
+     * the previous message ended the line */
+    format_line(avcl, level, fmt, vl, part, &print_prefix, NULL);
+    msg.time  = av_gettime();
+    msg.level = level;
+    msg.avcl  = avcl;
+    snprintf(msg.prefix, sizeof(msg.prefix), "%s%s%s",
+             part[0].str, part[1].str, part[2].str);
+    av_strlcpy(msg.name, avc ? avc->item_name(avcl) : "", sizeof(msg.name));
+    av_strlcpy(msg.text, part[3].str, sizeof(msg.text));
+    av_bprint_finalize(part+3, NULL);
+
+    if (av_thread_message_queue_send(async_log_queue, &msg,
+                                     AV_THREAD_MESSAGE_NONBLOCK) < 0)
+        atomic_fetch_add_explicit(&async_log_dropped, 1, memory_order_relaxed);
+}
+
+static void json_string(AVBPrint *bp, const char *s, size_t len)
+{
+    av_bprint_chars(bp, '"', 1);
+    for (; len; len--, s++) {
+        if (*s == '"' || *s == '\\')
+            av_bprintf(bp, "\\%c", *s);
+        else if ((uint8_t)*s < 0x20)
+            av_bprintf(bp, "\\u%04x", *s);
+        else
+            av_bprint_chars(bp, *s, 1);
+    }
+    av_bprint_chars(bp, '"', 1);
+}
+
+static void async_log_write(const AsyncLogMessage *msg)
+{
+    size_t len = strlen(msg->text);
+    AVBPrint bp;
+
+    if (async_log_flags & AV_LOG_ASYNC_JSON) {
+        while (len && (msg->text[len - 1] == '\n' || msg->text[len - 1] == '\r'))
+            len--;
+        av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+        av_bprintf(&bp, "{\"time\":%"PRId64".%06d,\"level\":\"%s\",\"context\":",
+                   msg->time / 1000000, (int)(msg->time % 1000000),
+                   get_level_str(msg->level));
+        if (msg->avcl) {
+            json_string(&bp, msg->name, strlen(msg->name));
+            av_bprintf(&bp, ",\"address\":\"%p\"", msg->avcl);
+        } else {
+            av_bprintf(&bp, "null,\"address\":null");
+        }
+        av_bprintf(&bp, ",\"message\":");
+        json_string(&bp, msg->text, len);
+        av_bprintf(&bp, "}\n");
+        if (av_bprint_is_complete(&bp))
+            fputs(bp.str, async_log_file);
+        av_bprint_finalize(&bp, NULL);
+    } else {
+        char text[LINE_SZ];
+
+        memcpy(text, msg->text, len + 1);
+        sanitize((uint8_t *)text);
+        if (async_log_line_start)
+            fputs(msg->prefix, async_log_file);
+        fputs(text, async_log_file);
+        if (len)
+            async_log_line_start = text[len - 1] == '\n' || text[len - 1] == '\r';
+    }
+}
+
+/* write a message of the writer thread about the messages of a context */
+static void async_log_write_note(const AsyncLogMessage *ref, const char *fmt, int count)
+{
+    AsyncLogMessage msg = *ref;
+
+    snprintf(msg.text, sizeof(msg.text), fmt, count);
+    async_log_line_start = 1;
+    async_log_write(&msg);
+}
+
+static void async_log_flush_context(AsyncLogContext *c)
+{
+    if (c->repeated)
+        async_log_write_note(&c->last, "Last message repeated %d times\n", c->repeated);
+    if (c->suppressed)
+        async_log_write_note(&c->last, "%d messages suppressed\n", c->suppressed);
+    c->repeated = c->suppressed = 0;
+}
+
+static void async_log_process(const AsyncLogMessage *msg)
+{
+    AsyncLogContext *c = &async_log_contexts[((uintptr_t)msg->avcl >> 4) % ASYNC_LOG_CONTEXTS];
+    size_t len = strlen(msg->text);
+
+    if (c->used && c->last.avcl != msg->avcl) {
+        async_log_flush_context(c);
+        c->used = 0;
+    }
+    if (!c->used) {
+        memset(c, 0, sizeof(*c));
+        c->used         = 1;
+        c->window_start = msg->time;
+    }
+
+    if (len && msg->text[len - 1] == '\n' && msg->level == c->last.level &&
+        !strcmp(msg->text, c->last.text)) {
+        c->repeated++;
+        return;
+    }
+    if (c->repeated) {
+        async_log_write_note(&c->last, "Last message repeated %d times\n", c->repeated);
+        c->repeated = 0;
+    }
+
+    if (async_log_max_rate) {
+        if (msg->time - c->window_start >= 1000000) {
+            if (c->suppressed)
+                async_log_write_note(&c->last, "%d messages suppressed\n", c->suppressed);
+            c->suppressed   = 0;
+            c->window_start = msg->time;
+            c->window_count = 0;
+        }
+        if (c->window_count++ >= async_log_max_rate) {
+            c->suppressed++;
+            return;
+        }
+    }
+
+    c->last = *msg;
+    async_log_write(msg);
+}
+
+static void async_log_report_dropped(void)
+{
+    int dropped = atomic_exchange_explicit(&async_log_dropped, 0, memory_order_relaxed);
+
+    if (dropped) {
+        AsyncLogMessage msg = { .time = av_gettime(), .level = AV_LOG_WARNING };
+
+        async_log_write_note(&msg, "%d log messages dropped\n", dropped);
+    }
+}
+
+static void *async_log_thread_main(void *arg)
+{
+    AsyncLogMessage msg;
+    int i;
+
+    /* The queue is polled rather than waited on: a sleeping receiver would
+     * make every sender take the queue lock to wake it up, and the log
+     * callback must never block. */
+    for (;;) {
+        int ret = av_thread_message_queue_recv(async_log_queue, &msg,
+                                               AV_THREAD_MESSAGE_NONBLOCK);
+        if (ret == AVERROR(EAGAIN)) {
+            av_usleep(ASYNC_LOG_POLL_US);
+            continue;
+        }
+        if (ret < 0)
+            break;
+        async_log_process(&msg);
+        async_log_report_dropped();
+    }
+
+    for (i = 0; i < ASYNC_LOG_CONTEXTS; i++)
+        async_log_flush_context(&async_log_contexts[i]);
+    async_log_report_dropped();
+    fflush(async_log_file);
+    return NULL;
+}
+
+#endif /* HAVE_THREADS */
+
+int av_log_async_start(int flags, int max_rate)
+{
+#if HAVE_THREADS
+    int ret;
+
+    if (async_log_queue || max_rate < 0)
+        return AVERROR(EINVAL);
+
+    ret = av_thread_message_queue_alloc2(&async_log_queue, ASYNC_LOG_QUEUE_SIZE,
+                                         sizeof(AsyncLogMessage),
+                                         AV_THREAD_MESSAGE_QUEUE_MPSC);
+    if (ret < 0)
+        return ret;
+    async_log_contexts = av_mallocz_array(ASYNC_LOG_CONTEXTS, sizeof(*async_log_contexts));
+    if (!async_log_contexts) {
+        av_thread_message_queue_free(&async_log_queue);
+        return AVERROR(ENOMEM);
+    }
+    async_log_flags      = flags;
+    async_log_max_rate   = max_rate;
+    async_log_line_start = 1;
+    async_log_file       = stderr;
+    atomic_store(&async_log_dropped, 0);
+
+    if ((ret = pthread_create(&async_log_thread, NULL, async_log_thread_main, NULL))) {
+        av_freep(&async_log_contexts);
+        av_thread_message_queue_free(&async_log_queue);
+        return AVERROR(ret);
+    }
+
+    async_log_prev_callback = av_log_callback;
+    av_log_set_callback(async_log_callback);
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif /* HAVE_THREADS */
+}
+
+void av_log_async_stop(void)
+{
+#if HAVE_THREADS
+    if (!async_log_queue)
+        return;
+
+    av_log_set_callback(async_log_prev_callback);
+    /* the messages already queued are still received */
+    av_thread_message_queue_set_err_recv(async_log_queue, AVERROR_EOF);
+    pthread_join(async_log_thread, NULL);
+    av_thread_message_queue_free(&async_log_queue);
+    av_freep(&async_log_contexts);
+#endif /* HAVE_THREADS */
+}
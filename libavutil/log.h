@@ -369,6 +369,46 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
 void av_log_set_flags(int arg);
 int av_log_get_flags(void);
 
+/**
+ * Write the messages as JSON objects, one per line, with the fields "time"
+ * (in seconds since the epoch), "level", "context" (the item name of the
+ * logging context, or null), "address" (of the logging context) and
+ * "message".
+ */
+#define AV_LOG_ASYNC_JSON 1
+
+/**
+ * Start writing the log messages to stderr from a background thread.
+ *
+ * The log callback is replaced with one which formats the message on the
+ * calling thread and hands it to the background thread without blocking or
+ * taking any lock; the background thread polls for new messages.
+ * If the background thread falls behind, the messages that do not fit in
+ * its queue are dropped and their number reported later.
+ *
+ * The background thread collapses the messages repeated by the same
+ * context, as AV_LOG_SKIP_REPEATED does, and can limit the number of
+ * messages written for each context.
+ *
+ * This must not be called while other threads may log.
+ *
+ * @param flags    a combination of AV_LOG_ASYNC_* flags
+ * @param max_rate maximum number of messages written for each context each
+ *                 second, 0 for no limit
+ * @return 0 on success, a negative AVERROR code on failure, in particular
+ *         AVERROR(ENOSYS) if lavu was built without thread support
+ */
+int av_log_async_start(int flags, int max_rate);
+
+/**
+ * Write the pending messages, stop the background thread started by
+ * av_log_async_start() and restore the log callback that was set when it
+ * was called.
+ *
+ * This must not be called while other threads may log.
+ */
+void av_log_async_stop(void);
+
 /**
  * @}
  */
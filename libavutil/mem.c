@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +43,7 @@
 #include "dynarray.h"
 #include "intreadwrite.h"
 #include "mem.h"
+#include "thread.h"
 
 #ifdef MALLOC_PREFIX
 
@@ -475,3 +477,189 @@ void av_fast_mallocz(void *ptr, unsigned int *size, size_t min_size)
 {
     ff_fast_malloc(ptr, size, min_size, 1);
 }
+
+struct AVMemAccount {
+    char *name;
+    void *owner;
+    AVMemAccount *parent;
+    AVMemAccount *next;     ///< next named account
+    atomic_int refcount;
+
+    AVMutex lock;           ///< protects the fields below
+    int64_t current;
+    int64_t peak;
+    int64_t budget;
+    AVMemBudgetCallback budget_cb;
+    void *budget_opaque;
+};
+
+/* The named accounts. The references to them are also taken and released
+ * under the lock, so that av_mem_account_find() does not return an
+ * account being freed. */
+static AVMemAccount *accounts;
+static AVMutex accounts_mutex;
+static AVOnce accounts_once = AV_ONCE_INIT;
+
+static av_cold void accounts_init(void)
+{
+    ff_mutex_init(&accounts_mutex, NULL);
+}
+
+static AVMemAccount *find_account(const char *name)
+{
+    AVMemAccount *acc;
+
+    for (acc = accounts; acc; acc = acc->next)
+        if (!strcmp(acc->name, name))
+            return acc;
+    return NULL;
+}
+
+int av_mem_account_alloc(AVMemAccount **pacc, const char *name, void *owner,
+                         AVMemAccount *parent)
+{
+    AVMemAccount *acc = av_mallocz(sizeof(*acc));
+
+    if (!acc)
+        return AVERROR(ENOMEM);
+    if (name && !(acc->name = av_strdup(name))) {
+        av_free(acc);
+        return AVERROR(ENOMEM);
+    }
+    if (ff_mutex_init(&acc->lock, NULL)) {
+        av_free(acc->name);
+        av_free(acc);
+        return AVERROR(ENOMEM);
+    }
+    acc->owner  = owner;
+    acc->parent = parent ? av_mem_account_ref(parent) : NULL;
+    atomic_init(&acc->refcount, 1);
+
+    if (name) {
+        ff_thread_once(&accounts_once, accounts_init);
+        ff_mutex_lock(&accounts_mutex);
+        if (find_account(name)) {
+            ff_mutex_unlock(&accounts_mutex);
+            av_mem_account_unref(&acc);
+            return AVERROR(EEXIST);
+        }
+        acc->next = accounts;
+        accounts  = acc;
+        ff_mutex_unlock(&accounts_mutex);
+    }
+
+    *pacc = acc;
+    return 0;
+}
+
+AVMemAccount *av_mem_account_find(const char *name)
+{
+    AVMemAccount *acc;
+
+    ff_thread_once(&accounts_once, accounts_init);
+    ff_mutex_lock(&accounts_mutex);
+    if ((acc = find_account(name)))
+        atomic_fetch_add_explicit(&acc->refcount, 1, memory_order_relaxed);
+    ff_mutex_unlock(&accounts_mutex);
+    return acc;
+}
+
+AVMemAccount *av_mem_account_ref(AVMemAccount *acc)
+{
+    atomic_fetch_add_explicit(&acc->refcount, 1, memory_order_relaxed);
+    return acc;
+}
+
+void av_mem_account_unref(AVMemAccount **pacc)
+{
+    AVMemAccount *acc = *pacc, *parent, **p;
+    int last;
+
+    if (!acc)
+        return;
+    *pacc = NULL;
+
+    if (!acc->name)
+        last = atomic_fetch_add_explicit(&acc->refcount, -1, memory_order_acq_rel) == 1;
+    else {
+        ff_mutex_lock(&accounts_mutex);
+        last = atomic_fetch_add_explicit(&acc->refcount, -1, memory_order_acq_rel) == 1;
+        for (p = &accounts; last && *p; p = &(*p)->next) {
+            if (*p == acc) {
+                *p = acc->next;
+                break;
+            }
+        }
+        ff_mutex_unlock(&accounts_mutex);
+    }
+    if (!last)
+        return;
+
+    /* what the account still holds is no longer attributed to anyone */
+    parent = acc->parent;
+    av_mem_account_add(parent, -acc->current);
+    ff_mutex_destroy(&acc->lock);
+    av_free(acc->name);
+    av_free(acc);
+    av_mem_account_unref(&parent);
+}
+
+void *av_mem_account_get_owner(const AVMemAccount *acc)
+{
+    return acc->owner;
+}
+
+void av_mem_account_add(AVMemAccount *acc, int64_t size)
+{
+    for (; acc; acc = acc->parent) {
+        AVMemBudgetCallback cb;
+        void *opaque;
+        int64_t current;
+        int over;
+
+        ff_mutex_lock(&acc->lock);
+        over = acc->budget && acc->current <= acc->budget &&
+               acc->current + size > acc->budget;
+        acc->current += size;
+        acc->peak     = FFMAX(acc->peak, acc->current);
+        current       = acc->current;
+        cb            = acc->budget_cb;
+        opaque        = acc->budget_opaque;
+        ff_mutex_unlock(&acc->lock);
+
+        if (over && cb)
+            cb(opaque, acc, current);
+    }
+}
+
+void av_mem_account_get_usage(AVMemAccount *acc, int64_t *current, int64_t *peak)
+{
+    ff_mutex_lock(&acc->lock);
+    if (current)
+        *current = acc->current;
+    if (peak)
+        *peak = acc->peak;
+    ff_mutex_unlock(&acc->lock);
+}
+
+void av_mem_account_set_budget(AVMemAccount *acc, int64_t budget,
+                               AVMemBudgetCallback cb, void *opaque)
+{
+    ff_mutex_lock(&acc->lock);
+    acc->budget        = budget;
+    acc->budget_cb     = cb;
+    acc->budget_opaque = opaque;
+    ff_mutex_unlock(&acc->lock);
+}
+
+int av_mem_account_over_budget(AVMemAccount *acc)
+{
+    int over = 0;
+
+    for (; acc && !over; acc = acc->parent) {
+        ff_mutex_lock(&acc->lock);
+        over = acc->budget && acc->current > acc->budget;
+        ff_mutex_unlock(&acc->lock);
+    }
+    return over;
+}
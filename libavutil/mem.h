@@ -691,6 +691,123 @@ static inline int av_size_mult(size_t a, size_t b, size_t *r)
  */
 void av_max_alloc(size_t max);
 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup lavu_mem_account Memory Accounting
+ *
+ * Optional accounting of the memory held by components, attributed to the
+ * context owning it.
+ *
+ * An application creates a named account for each of its sessions, and
+ * passes the name to the components through their "mem_account" option.
+ * The components then create a child account owned by their context and
+ * report to it the size of the buffers they hold. The usage of an account
+ * includes the usage of its children, so that it adds up to the whole
+ * session.
+ *
+ * A budget can be set on an account. It is soft: going over it does not
+ * make allocations fail, but calls the budget callback and makes
+ * av_mem_account_over_budget() return 1 for the account and its children,
+ * which some components use to shed buffering.
+ *
+ * All functions can be called from any thread.
+ *
+ * @{
+ */
+
+typedef struct AVMemAccount AVMemAccount;
+
+/**
+ * Callback called when the usage of an account goes over its budget.
+ *
+ * It is called from the thread whose allocation made the usage go over the
+ * budget, which may be a component thread, and should return quickly.
+ *
+ * @param opaque the opaque pointer given to av_mem_account_set_budget()
+ * @param acc    the account over budget
+ * @param usage  the current usage of the account, in bytes
+ */
+typedef void (*AVMemBudgetCallback)(void *opaque, AVMemAccount *acc, int64_t usage);
+
+/**
+ * Allocate a memory account.
+ *
+ * @param acc    pointer to the new account, with one reference owned by the
+ *               caller
+ * @param name   if not NULL, name under which the account can be found
+ *               with av_mem_account_find() until it is freed
+ * @param owner  context whose memory the account holds, typically a
+ *               struct whose first member is a pointer to an AVClass;
+ *               may be NULL
+ * @param parent if not NULL, account whose usage includes the usage of
+ *               this one; the new account holds a reference to it
+ * @return 0 on success, AVERROR(EEXIST) if an account with the same name
+ *         exists, another negative AVERROR code on failure
+ */
+int av_mem_account_alloc(AVMemAccount **acc, const char *name, void *owner,
+                         AVMemAccount *parent);
+
+/**
+ * Find a named account.
+ *
+ * @return a new reference to the account, or NULL if there is none with
+ *         this name
+ */
+AVMemAccount *av_mem_account_find(const char *name);
+
+/**
+ * Create a new reference to an account.
+ *
+ * @return acc
+ */
+AVMemAccount *av_mem_account_ref(AVMemAccount *acc);
+
+/**
+ * Release a reference to an account, freeing it if it was the last one,
+ * and set the pointer to NULL.
+ */
+void av_mem_account_unref(AVMemAccount **acc);
+
+/**
+ * @return the owner given to av_mem_account_alloc()
+ */
+void *av_mem_account_get_owner(const AVMemAccount *acc);
+
+/**
+ * Add to the usage of an account and of its parents.
+ *
+ * @param acc  the account, if NULL nothing is done
+ * @param size the number of bytes taken, or released if negative
+ */
+void av_mem_account_add(AVMemAccount *acc, int64_t size);
+
+/**
+ * Get the usage of an account.
+ *
+ * @param current if not NULL, set to the number of bytes currently held
+ * @param peak    if not NULL, set to the highest value of the usage
+ */
+void av_mem_account_get_usage(AVMemAccount *acc, int64_t *current, int64_t *peak);
+
+/**
+ * Set the budget of an account.
+ *
+ * @param budget budget in bytes, 0 for none
+ * @param cb     if not NULL, called when the usage goes over the budget
+ * @param opaque passed to cb
+ */
+void av_mem_account_set_budget(AVMemAccount *acc, int64_t budget,
+                               AVMemBudgetCallback cb, void *opaque);
+
+/**
+ * @return 1 if the account or one of its parents is over its budget,
+ *         0 otherwise or if acc is NULL
+ */
+int av_mem_account_over_budget(AVMemAccount *acc);
+
 /**
  * @}
  * @}
@@ -0,0 +1,148 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program stresses AVBufferPool from several threads, checking
+ * that no buffer is handed out twice. With -b it measures the cost of
+ * getting and releasing a buffer for increasing numbers of threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define MAX_THREADS 16
+#define MAX_HELD    4
+#define BUF_SIZE    64
+
+typedef struct ThreadData {
+    AVBufferPool *pool;
+    int id;
+    int iterations;
+    int check;
+    int errors;
+} ThreadData;
+
+static void *thread_main(void *arg)
+{
+    ThreadData *td = arg;
+    AVBufferRef *held[MAX_HELD];
+    unsigned seed = td->id * 1103515245U + 12345;
+    int i, j;
+
+    for (i = 0; i < td->iterations; i++) {
+        int nb = td->check ? 1 + (seed >> 16) % MAX_HELD : 1;
+
+        seed = seed * 1103515245U + 12345;
+        for (j = 0; j < nb; j++) {
+            held[j] = av_buffer_pool_get(td->pool);
+            if (!held[j]) {
+                td->errors++;
+                nb = j;
+                break;
+            }
+            if (td->check)
+                AV_WN32(held[j]->data, td->id << 16 | (i & 0xff) << 8 | j);
+        }
+        for (j = 0; j < nb; j++) {
+            if (td->check &&
+                AV_RN32(held[j]->data) != (td->id << 16 | (i & 0xff) << 8 | j))
+                td->errors++;
+            av_buffer_unref(&held[j]);
+        }
+    }
+    return NULL;
+}
+
+static int run(int nb_threads, int iterations, int check, int64_t *time)
+{
+    ThreadData td[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    AVBufferPool *pool = av_buffer_pool_init(BUF_SIZE, NULL);
+    int64_t start;
+    int i, ret, errors = 0;
+
+    if (!pool)
+        return -1;
+
+    start = av_gettime_relative();
+    for (i = 0; i < nb_threads; i++) {
+        td[i] = (ThreadData){ .pool = pool, .id = i + 1,
+                              .iterations = iterations, .check = check };
+        if ((ret = pthread_create(&threads[i], NULL, thread_main, &td[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            exit(1);
+        }
+    }
+    for (i = 0; i < nb_threads; i++) {
+        pthread_join(threads[i], NULL);
+        errors += td[i].errors;
+    }
+    if (time)
+        *time = av_gettime_relative() - start;
+
+    av_buffer_pool_uninit(&pool);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int nb_threads, errors;
+
+    if (argc > 1 && !strcmp(argv[1], "-b")) {
+        int iterations = 1000000;
+
+        for (nb_threads = 1; nb_threads <= MAX_THREADS; nb_threads *= 2) {
+            int64_t time;
+
+            run(nb_threads, iterations, 0, &time);
+            printf("%2d threads: %6.1f ns per get and release in each thread\n", nb_threads,
+                   time * 1000.0 / iterations);
+        }
+        return 0;
+    }
+
+    for (nb_threads = 1; nb_threads <= 8; nb_threads *= 2) {
+        errors = run(nb_threads, 20000, 1, NULL);
+        if (errors) {
+            fprintf(stderr, "%d threads: %d errors\n", nb_threads, errors);
+            return 1;
+        }
+    }
+
+    /* buffers released after the pool was uninited */
+    {
+        AVBufferPool *pool = av_buffer_pool_init(BUF_SIZE, NULL);
+        AVBufferRef *a = av_buffer_pool_get(pool);
+        AVBufferRef *b = av_buffer_pool_get(pool);
+
+        if (!a || !b || a->data == b->data)
+            return 1;
+        av_buffer_unref(&a);
+        av_buffer_pool_uninit(&pool);
+        av_buffer_unref(&b);
+    }
+
+    return 0;
+}
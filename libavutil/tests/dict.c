@@ -49,6 +49,42 @@ static void test_separators(const AVDictionary *m, const char pair, const char v
     av_dict_free(&dict);
 }
 
+/* the result of av_dict_get() for an exact key, without the hash index */
+static AVDictionaryEntry *linear_get(const AVDictionary *m, const char *key, int flags)
+{
+    AVDictionaryEntry *t = NULL;
+
+    while ((t = av_dict_get(m, "", t, AV_DICT_IGNORE_SUFFIX)))
+        if (flags & AV_DICT_MATCH_CASE ? !strcmp(t->key, key)
+                                       : !av_strcasecmp(t->key, key))
+            return t;
+    return NULL;
+}
+
+static void test_hash_index(void)
+{
+    AVDictionary *dict = NULL;
+    char key[16];
+    int i, j, errors = 0;
+
+    for (i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), i & 1 ? "Key%d" : "key%d", i % 150);
+        av_dict_set_int(&dict, key, i, i % 7 ? 0 : AV_DICT_MULTIKEY);
+        snprintf(key, sizeof(key), "key%d", (i * 37) % 150);
+        if (i % 5 == 4)
+            av_dict_set(&dict, key, NULL, 0);
+
+        for (j = 0; j < 160; j++) {
+            snprintf(key, sizeof(key), j & 2 ? "KEY%d" : "key%d", j);
+            errors += av_dict_get(dict, key, NULL, 0) != linear_get(dict, key, 0);
+            errors += av_dict_get(dict, key, NULL, AV_DICT_MATCH_CASE) !=
+                      linear_get(dict, key, AV_DICT_MATCH_CASE);
+        }
+    }
+    printf("%d entries, %d errors\n", av_dict_count(dict), errors);
+    av_dict_free(&dict);
+}
+
 int main(void)
 {
     AVDictionary *dict = NULL;
@@ -132,5 +168,8 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting lookups through the hash index\n");
+    test_hash_index();
+
     return 0;
 }
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "libavutil/common.h"
 #include "libavutil/libm.h"
 #include "libavutil/eval.h"
 
@@ -39,7 +40,7 @@ static const char *const const_names[] = {
 
 int main(int argc, char **argv)
 {
-    int i;
+    int i, j;
     double d;
     const char *const *expr;
     static const char *const exprs[] = {
@@ -140,6 +141,24 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const batch_names[] = { "X", "Y", "PI", NULL };
+    static const char *const batch_exprs[] = {
+        "X*Y+PI",
+        "if(gt(X,3),hypot(X-4,Y),-sqrt(X+3))",
+        "clip(X*2-5,0,Y);lerp(X,Y,0.25)",
+        "between(X,-1,1)*floor(X)+mod(X,2)^2",
+        "st(0,ld(0)+X);ld(0)",
+        "1+2*3-sin(0)",
+        NULL
+    };
+    static const char *const stateless_exprs[] = {
+        "X*Y+hypot(X,Y)",
+        "st(0,X);ld(0)",
+        "random(0)",
+        "time(0)",
+        "128+127*sin(time(0))",
+        NULL
+    };
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -168,6 +187,38 @@ int main(int argc, char **argv)
     if (ret < 0)
         printf("av_expr_parse_and_eval failed\n");
 
+    for (expr = batch_exprs; *expr; expr++) {
+        AVExpr *e[2];
+        double x[37], res[2][37];
+        double values[] = { 0, 7, M_PI };
+        const double *arrays[] = { x, NULL, NULL };
+
+        if (av_expr_parse(&e[0], *expr, batch_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+            av_expr_parse(&e[1], *expr, batch_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+            return 1;
+        for (j = 0; j < FF_ARRAY_ELEMS(x); j++)
+            x[j] = j * 0.5 - 3;
+        if (av_expr_eval_batch(e[0], res[0], FF_ARRAY_ELEMS(x), values, arrays, NULL) < 0)
+            printf("av_expr_eval_batch failed\n");
+        for (j = 0; j < FF_ARRAY_ELEMS(x); j++) {
+            values[0] = x[j];
+            res[1][j] = av_expr_eval(e[1], values, NULL);
+        }
+        printf("Batch evaluating '%s' -> %f %f %s\n", *expr, res[0][0], res[0][36],
+               memcmp(res[0], res[1], sizeof(res[0])) ? "mismatch" : "ok");
+        av_expr_free(e[0]);
+        av_expr_free(e[1]);
+    }
+
+    for (expr = stateless_exprs; *expr; expr++) {
+        AVExpr *e;
+
+        if (av_expr_parse(&e, *expr, batch_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+            return 1;
+        printf("'%s' is %s\n", *expr, av_expr_is_stateless(e) ? "stateless" : "stateful");
+        av_expr_free(e);
+    }
+
     if (argc > 1 && !strcmp(argv[1], "-t")) {
         for (i = 0; i < 1050; i++) {
             START_TIMER;
@@ -34,6 +34,70 @@ static int call_log_format_line2(const char *fmt, char *buffer, int buffer_size,
     return ret;
 }
 
+static int user_callback_calls;
+
+static void user_callback(void *avcl, int level, const char *fmt, va_list vl)
+{
+    user_callback_calls++;
+}
+
+#if HAVE_THREADS
+/* two logging contexts which fall into different slots of the writer */
+static const char async_contexts[2][16];
+
+static void async_log_test_message(int ctx, int64_t time, int level, const char *text)
+{
+    AsyncLogMessage msg = { .time = time, .level = level };
+
+    if (ctx >= 0) {
+        msg.avcl = async_contexts[ctx];
+        snprintf(msg.prefix, sizeof(msg.prefix), "[ctx%d] ", ctx);
+        snprintf(msg.name, sizeof(msg.name), "ctx%d", ctx);
+    }
+    av_strlcpy(msg.text, text, sizeof(msg.text));
+    async_log_process(&msg);
+}
+
+/* Run the writer thread's processing on messages with fixed timestamps and
+ * write its output to stdout. The JSON output contains the addresses of the
+ * contexts, so it is only tested without a context. */
+static int async_log_test(int flags)
+{
+    int json = flags & AV_LOG_ASYNC_JSON;
+    int64_t t = json ? 1234567000089 : 0;
+    int i;
+
+    async_log_contexts = av_mallocz_array(ASYNC_LOG_CONTEXTS, sizeof(*async_log_contexts));
+    if (!async_log_contexts)
+        return AVERROR(ENOMEM);
+    async_log_flags      = flags;
+    async_log_max_rate   = 3;
+    async_log_line_start = 1;
+    async_log_file       = stdout;
+
+    for (i = 0; i < 3; i++)
+        async_log_test_message(json ? -1 : 0, t, AV_LOG_WARNING, "repeated\n");
+    if (json) {
+        async_log_test_message(-1, t + 1, AV_LOG_ERROR,
+                               "escaped \"quote\" \\ and\ttab\n");
+    } else {
+        async_log_test_message(1, t + 1, AV_LOG_INFO, "partial ");
+        async_log_test_message(1, t + 2, AV_LOG_INFO, "line\n");
+    }
+    for (i = 0; i < 4; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "rate limited %d\n", i);
+        async_log_test_message(json ? -1 : 0, t + 1000 + i, AV_LOG_INFO, text);
+    }
+    async_log_test_message(json ? -1 : 0, t + 1500000, AV_LOG_INFO, "next second\n");
+
+    for (i = 0; i < ASYNC_LOG_CONTEXTS; i++)
+        async_log_flush_context(&async_log_contexts[i]);
+    av_freep(&async_log_contexts);
+    return 0;
+}
+#endif /* HAVE_THREADS */
+
 int main(int argc, char **argv)
 {
     int i;
@@ -67,5 +131,42 @@ int main(int argc, char **argv)
             return 1;
         }
     }
+
+    for (i = 0; i <= AV_LOG_ASYNC_JSON; i++) {
+        int j, ret = av_log_async_start(i, 2);
+
+        if (ret == AVERROR(ENOSYS))
+            break;
+        if (ret < 0) {
+            printf("Test async start failed.\n");
+            return 1;
+        }
+        for (j = 0; j < 3; j++)
+            av_log(NULL, AV_LOG_WARNING, "repeated \"%s\"\n", i ? "json" : "text");
+        for (j = 0; j < 4; j++)
+            av_log(NULL, AV_LOG_INFO, "rate limited %d\n", j);
+        av_log_async_stop();
+    }
+
+    /* the callback set before starting comes back when stopping */
+    av_log_set_callback(user_callback);
+    if (av_log_async_start(0, 0) >= 0)
+        av_log_async_stop();
+    av_log(NULL, AV_LOG_INFO, "user callback\n");
+    av_log_set_callback(av_log_default_callback);
+    if (user_callback_calls != 1) {
+        printf("Test async callback restore failed.\n");
+        return 1;
+    }
+
+#if HAVE_THREADS
+    for (i = 0; i <= AV_LOG_ASYNC_JSON; i++) {
+        printf("async %s:\n", i ? "json" : "text");
+        if (async_log_test(i) < 0) {
+            printf("Test async output failed.\n");
+            return 1;
+        }
+    }
+#endif
     return 0;
 }
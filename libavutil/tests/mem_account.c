@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/mem.h"
+
+static char session_name[] = "session";
+
+static void budget_cb(void *opaque, AVMemAccount *acc, int64_t usage)
+{
+    printf("%s over budget: %"PRId64"\n", (const char *)opaque, usage);
+}
+
+static void print_usage(const char *name, AVMemAccount *acc)
+{
+    int64_t current, peak;
+
+    av_mem_account_get_usage(acc, &current, &peak);
+    printf("%s: current %"PRId64" peak %"PRId64" over budget %d\n",
+           name, current, peak, av_mem_account_over_budget(acc));
+}
+
+int main(void)
+{
+    AVMemAccount *session, *found, *a, *b;
+    int ret;
+
+    if (av_mem_account_alloc(&session, "session", NULL, NULL) < 0)
+        return 1;
+    ret = av_mem_account_alloc(&found, "session", NULL, NULL);
+    printf("same name: %s\n", ret == AVERROR(EEXIST) ? "EEXIST" : "unexpected");
+
+    found = av_mem_account_find("session");
+    printf("found: %d\n", found == session);
+    av_mem_account_unref(&found);
+    printf("not found: %d\n", !av_mem_account_find("other"));
+
+    av_mem_account_set_budget(session, 1000, budget_cb, session_name);
+    if (av_mem_account_alloc(&a, NULL, &ret, session) < 0 ||
+        av_mem_account_alloc(&b, NULL, NULL, session) < 0)
+        return 1;
+    printf("owner: %d\n", av_mem_account_get_owner(a) == &ret);
+
+    av_mem_account_add(a, 600);
+    av_mem_account_add(b, 300);
+    print_usage("session", session);
+    av_mem_account_add(b, 200);
+    av_mem_account_add(b, 100);
+    print_usage("a", a);
+    print_usage("session", session);
+    av_mem_account_add(a, -600);
+    print_usage("session", session);
+
+    /* what b still holds is released from the session when it is freed */
+    av_mem_account_unref(&b);
+    print_usage("session", session);
+    av_mem_account_unref(&session);
+    found = av_mem_account_find("session");
+    printf("found while referenced by a child: %d\n", !!found);
+    av_mem_account_unref(&found);
+    av_mem_account_unref(&a);
+    printf("found after freeing: %d\n", !!av_mem_account_find("session"));
+
+    av_mem_account_add(NULL, 1);
+    printf("NULL over budget: %d\n", av_mem_account_over_budget(NULL));
+    return 0;
+}
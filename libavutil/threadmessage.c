@@ -18,6 +18,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+
+#include "common.h"
 #include "fifo.h"
 #include "threadmessage.h"
 #include "thread.h"
@@ -28,10 +31,23 @@ struct AVThreadMessageQueue {
     pthread_mutex_t lock;
     pthread_cond_t cond_recv;
     pthread_cond_t cond_send;
-    int err_send;
-    int err_recv;
+    atomic_int err_send;
+    atomic_int err_recv;
     unsigned elsize;
     void (*free_func)(void *msg);
+
+    /* With AV_THREAD_MESSAGE_QUEUE_MPSC/SPSC, the messages go through a ring
+     * instead of the fifo; the lock and conditions are then only used to
+     * sleep while the ring is empty or full. */
+    unsigned flags;
+    unsigned nelem;
+    unsigned mask;          ///< ring size - 1, the ring size being a power of 2
+    uint8_t *ring;
+    atomic_intptr_t *seq;      ///< position + 1 of the message in each ring entry, once written
+    atomic_intptr_t write_pos; ///< position of the next message to write
+    atomic_intptr_t read_pos;  ///< position of the next message to read
+    atomic_int recv_waiting;
+    atomic_int send_waiting;
 #else
     int dummy;
 #endif
@@ -40,34 +56,79 @@ struct AVThreadMessageQueue {
 int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
                                   unsigned nelem,
                                   unsigned elsize)
+{
+    return av_thread_message_queue_alloc2(mq, nelem, elsize, 0);
+}
+
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags)
 {
 #if HAVE_THREADS
     AVThreadMessageQueue *rmq;
+    unsigned i;
     int ret = 0;
 
-    if (nelem > INT_MAX / elsize)
+    if (nelem > INT_MAX / elsize ||
+        flags & ~(AV_THREAD_MESSAGE_QUEUE_MPSC | AV_THREAD_MESSAGE_QUEUE_SPSC))
         return AVERROR(EINVAL);
     if (!(rmq = av_mallocz(sizeof(*rmq))))
         return AVERROR(ENOMEM);
+    if (flags) {
+        unsigned size = nelem > 1 ? 1U << av_log2(2 * nelem - 1) : 1;
+
+        if (nelem > INT_MAX / 2 / elsize) {
+            av_free(rmq);
+            return AVERROR(EINVAL);
+        }
+        rmq->ring = av_malloc_array(size, elsize);
+        rmq->seq  = av_calloc(size, sizeof(*rmq->seq));
+        if (!rmq->ring || !rmq->seq) {
+            av_freep(&rmq->ring);
+            av_freep(&rmq->seq);
+            av_free(rmq);
+            return AVERROR(ENOMEM);
+        }
+        rmq->flags = flags;
+        rmq->nelem = nelem;
+        rmq->mask  = size - 1;
+        for (i = 0; i < size; i++)
+            atomic_init(&rmq->seq[i], 0);
+        atomic_init(&rmq->write_pos, 0);
+        atomic_init(&rmq->read_pos, 0);
+    }
+    atomic_init(&rmq->err_send, 0);
+    atomic_init(&rmq->err_recv, 0);
+    atomic_init(&rmq->recv_waiting, 0);
+    atomic_init(&rmq->send_waiting, 0);
     if ((ret = pthread_mutex_init(&rmq->lock, NULL))) {
+        av_free(rmq->ring);
+        av_free(rmq->seq);
         av_free(rmq);
         return AVERROR(ret);
     }
     if ((ret = pthread_cond_init(&rmq->cond_recv, NULL))) {
         pthread_mutex_destroy(&rmq->lock);
+        av_free(rmq->ring);
+        av_free(rmq->seq);
         av_free(rmq);
         return AVERROR(ret);
     }
     if ((ret = pthread_cond_init(&rmq->cond_send, NULL))) {
         pthread_cond_destroy(&rmq->cond_recv);
         pthread_mutex_destroy(&rmq->lock);
+        av_free(rmq->ring);
+        av_free(rmq->seq);
         av_free(rmq);
         return AVERROR(ret);
     }
-    if (!(rmq->fifo = av_fifo_alloc(elsize * nelem))) {
+    if (!flags && !(rmq->fifo = av_fifo_alloc(elsize * nelem))) {
         pthread_cond_destroy(&rmq->cond_send);
         pthread_cond_destroy(&rmq->cond_recv);
         pthread_mutex_destroy(&rmq->lock);
+        av_free(rmq->ring);
+        av_free(rmq->seq);
         av_free(rmq);
         return AVERROR(ENOMEM);
     }
@@ -94,6 +155,8 @@ void av_thread_message_queue_free(AVThreadMessageQueue **mq)
     if (*mq) {
         av_thread_message_flush(*mq);
         av_fifo_freep(&(*mq)->fifo);
+        av_freep(&(*mq)->ring);
+        av_freep(&(*mq)->seq);
         pthread_cond_destroy(&(*mq)->cond_send);
         pthread_cond_destroy(&(*mq)->cond_recv);
         pthread_mutex_destroy(&(*mq)->lock);
@@ -138,6 +201,122 @@ static int av_thread_message_queue_recv_locked(AVThreadMessageQueue *mq,
     return 0;
 }
 
+/* wake the threads sleeping on cond if there are any */
+static void ring_wake(AVThreadMessageQueue *mq, atomic_int *waiting,
+                      pthread_cond_t *cond)
+{
+    /* pairs with the fence in ring_wait(): either the sleeping thread sees
+     * the change, or this one sees that it is going to sleep */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiting, memory_order_relaxed)) {
+        pthread_mutex_lock(&mq->lock);
+        pthread_cond_broadcast(cond);
+        pthread_mutex_unlock(&mq->lock);
+    }
+}
+
+/* sleep on cond, unless can_proceed() becomes true meanwhile */
+static void ring_wait(AVThreadMessageQueue *mq, atomic_int *waiting,
+                      pthread_cond_t *cond,
+                      int (*can_proceed)(AVThreadMessageQueue *mq))
+{
+    pthread_mutex_lock(&mq->lock);
+    atomic_fetch_add_explicit(waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!can_proceed(mq))
+        pthread_cond_wait(cond, &mq->lock);
+    atomic_fetch_add_explicit(waiting, -1, memory_order_relaxed);
+    pthread_mutex_unlock(&mq->lock);
+}
+
+#define RING_LOAD(x, order) ((uintptr_t)atomic_load_explicit(x, memory_order_ ## order))
+#define RING_ENTRY(mq, pos) ((mq)->ring + ((pos) & (mq)->mask) * (mq)->elsize)
+
+static int ring_can_send(AVThreadMessageQueue *mq)
+{
+    return atomic_load(&mq->err_send) ||
+           RING_LOAD(&mq->write_pos, relaxed) -
+           RING_LOAD(&mq->read_pos,  acquire) < mq->nelem;
+}
+
+static int ring_can_recv(AVThreadMessageQueue *mq)
+{
+    uintptr_t pos = RING_LOAD(&mq->read_pos, relaxed);
+
+    return atomic_load(&mq->err_recv) ||
+           RING_LOAD(&mq->seq[pos & mq->mask], acquire) == pos + 1;
+}
+
+static int ring_send(AVThreadMessageQueue *mq, void *msg, unsigned flags)
+{
+    uintptr_t pos = RING_LOAD(&mq->write_pos, relaxed);
+    int err;
+
+    for (;;) {
+        if ((err = atomic_load(&mq->err_send)))
+            return err;
+        /* The entry of a position less than nelem after the read position
+         * is free, as the reader only advances after copying it out. */
+        if (pos - RING_LOAD(&mq->read_pos, acquire) < mq->nelem) {
+            intptr_t expected = pos;
+
+            if (mq->flags & AV_THREAD_MESSAGE_QUEUE_SPSC) {
+                atomic_store_explicit(&mq->write_pos, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&mq->write_pos, &expected,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+            pos = expected;
+            continue;
+        }
+        if (flags & AV_THREAD_MESSAGE_NONBLOCK)
+            return AVERROR(EAGAIN);
+        ring_wait(mq, &mq->send_waiting, &mq->cond_send, ring_can_send);
+        pos = RING_LOAD(&mq->write_pos, relaxed);
+    }
+
+    memcpy(RING_ENTRY(mq, pos), msg, mq->elsize);
+    atomic_store_explicit(&mq->seq[pos & mq->mask], pos + 1, memory_order_release);
+    ring_wake(mq, &mq->recv_waiting, &mq->cond_recv);
+    return 0;
+}
+
+static int ring_recv(AVThreadMessageQueue *mq, void *msg, unsigned flags)
+{
+    uintptr_t pos = RING_LOAD(&mq->read_pos, relaxed);
+    int err;
+
+    /* a message that is still being written holds back the following ones */
+    while (RING_LOAD(&mq->seq[pos & mq->mask], acquire) != pos + 1) {
+        if ((err = atomic_load(&mq->err_recv)))
+            return err;
+        if (flags & AV_THREAD_MESSAGE_NONBLOCK)
+            return AVERROR(EAGAIN);
+        ring_wait(mq, &mq->recv_waiting, &mq->cond_recv, ring_can_recv);
+    }
+
+    memcpy(msg, RING_ENTRY(mq, pos), mq->elsize);
+    atomic_store_explicit(&mq->read_pos, pos + 1, memory_order_release);
+    ring_wake(mq, &mq->send_waiting, &mq->cond_send);
+    return 0;
+}
+
+static void ring_flush(AVThreadMessageQueue *mq)
+{
+    uintptr_t pos = RING_LOAD(&mq->read_pos, relaxed);
+
+    while (RING_LOAD(&mq->seq[pos & mq->mask], acquire) == pos + 1) {
+        if (mq->free_func)
+            mq->free_func(RING_ENTRY(mq, pos));
+        pos++;
+    }
+    atomic_store_explicit(&mq->read_pos, pos, memory_order_release);
+    ring_wake(mq, &mq->send_waiting, &mq->cond_send);
+}
+
 #endif /* HAVE_THREADS */
 
 int av_thread_message_queue_send(AVThreadMessageQueue *mq,
@@ -147,6 +326,9 @@ int av_thread_message_queue_send(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->flags)
+        return ring_send(mq, msg, flags);
+
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_send_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -163,6 +345,9 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->flags)
+        return ring_recv(mq, msg, flags);
+
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_recv_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -177,7 +362,7 @@ void av_thread_message_queue_set_err_send(AVThreadMessageQueue *mq,
 {
 #if HAVE_THREADS
     pthread_mutex_lock(&mq->lock);
-    mq->err_send = err;
+    atomic_store(&mq->err_send, err);
     pthread_cond_broadcast(&mq->cond_send);
     pthread_mutex_unlock(&mq->lock);
 #endif /* HAVE_THREADS */
@@ -188,7 +373,7 @@ void av_thread_message_queue_set_err_recv(AVThreadMessageQueue *mq,
 {
 #if HAVE_THREADS
     pthread_mutex_lock(&mq->lock);
-    mq->err_recv = err;
+    atomic_store(&mq->err_recv, err);
     pthread_cond_broadcast(&mq->cond_recv);
     pthread_mutex_unlock(&mq->lock);
 #endif /* HAVE_THREADS */
@@ -208,6 +393,11 @@ void av_thread_message_flush(AVThreadMessageQueue *mq)
     int used, off;
     void *free_func = mq->free_func;
 
+    if (mq->flags) {
+        ring_flush(mq);
+        return;
+    }
+
     pthread_mutex_lock(&mq->lock);
     used = av_fifo_size(mq->fifo);
     if (free_func)
@@ -32,6 +32,23 @@ typedef enum AVThreadMessageFlags {
 
 } AVThreadMessageFlags;
 
+typedef enum AVThreadMessageQueueFlags {
+
+    /**
+     * Several threads may send but only one thread receives and flushes the
+     * queue at a time. The messages are then passed through a lock-free ring
+     * and the threads only lock to sleep while the queue is empty or full.
+     */
+    AV_THREAD_MESSAGE_QUEUE_MPSC = 1,
+
+    /**
+     * Like AV_THREAD_MESSAGE_QUEUE_MPSC, with additionally only one thread
+     * sending at a time, which makes sending cheaper.
+     */
+    AV_THREAD_MESSAGE_QUEUE_SPSC = 2,
+
+} AVThreadMessageQueueFlags;
+
 /**
  * Allocate a new message queue.
  *
@@ -45,6 +62,23 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
                                   unsigned nelem,
                                   unsigned elsize);
 
+/**
+ * Allocate a new message queue for a given usage.
+ *
+ * @param mq      pointer to the message queue
+ * @param nelem   maximum number of elements in the queue
+ * @param elsize  size of each element in the queue
+ * @param flags   a combination of AVThreadMessageQueueFlags, 0 for a queue
+ *                that any number of threads can use, as allocated by
+ *                av_thread_message_queue_alloc()
+ * @return  >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *          lavu was built without thread support
+ */
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags);
+
 /**
  * Free a message queue.
  *
@@ -100,7 +134,8 @@ void av_thread_message_queue_set_free_func(AVThreadMessageQueue *mq,
  *
  * This function is mostly equivalent to reading and free-ing every message
  * except that it will be done in a single operation (no lock/unlock between
- * reads).
+ * reads). With AV_THREAD_MESSAGE_QUEUE_MPSC or AV_THREAD_MESSAGE_QUEUE_SPSC,
+ * it must only be called by the receiving thread.
  */
 void av_thread_message_flush(AVThreadMessageQueue *mq);
 
@@ -524,6 +524,12 @@ static int64_t get_delay(struct SwrContext *s, int64_t base){
     return av_rescale(num, base, s->in_sample_rate*(int64_t)c->src_incr * c->phase_count);
 }
 
+static int64_t get_filter_delay(struct SwrContext *s, int64_t base){
+    ResampleContext *c = s->resample;
+    // input samples after the one at the current output time that the filter uses
+    return av_rescale(c->filter_length / 2, base, s->in_sample_rate);
+}
+
 static int64_t get_out_samples(struct SwrContext *s, int in_samples) {
     ResampleContext *c = s->resample;
     // The + 2 are added to allow implementations to be slightly inaccurate, they should not be needed currently.
@@ -619,4 +625,5 @@ struct Resampler const swri_resampler={
   get_delay,
   invert_initial_buffer,
   get_out_samples,
+  get_filter_delay,
 };
@@ -264,7 +264,19 @@ av_cold int swr_init(struct SwrContext *s){
     }
 
     if (s->out_sample_rate!=s->in_sample_rate || (s->flags & SWR_FLAG_RESAMPLE)){
-        s->resample = s->resampler->init(s->resample, s->out_sample_rate, s->in_sample_rate, s->filter_size, s->phase_shift, s->linear_interp, s->cutoff, s->int_sample_fmt, s->filter_type, s->kaiser_beta, s->precision, s->cheby, s->exact_rational);
+        int filter_size    = s->filter_size;
+        int exact_rational = s->exact_rational;
+
+        /* Integer upsampling ratios, like the 8, 16 and 24 kHz of voice codecs
+         * to 48 kHz, have as many phases as the ratio and every output sample
+         * uses the next phase, so a short filter gives a small delay. */
+        if (s->low_delay && s->engine == SWR_ENGINE_SWR &&
+            s->out_sample_rate > s->in_sample_rate &&
+            s->out_sample_rate % s->in_sample_rate == 0) {
+            filter_size    = FFMIN(filter_size, SWR_LOW_DELAY_FILTER_SIZE);
+            exact_rational = 1;
+        }
+        s->resample = s->resampler->init(s->resample, s->out_sample_rate, s->in_sample_rate, filter_size, s->phase_shift, s->linear_interp, s->cutoff, s->int_sample_fmt, s->filter_type, s->kaiser_beta, s->precision, s->cheby, exact_rational);
         if (!s->resample) {
             av_log(s, AV_LOG_ERROR, "Failed to initialize resampler\n");
             return AVERROR(ENOMEM);
@@ -864,6 +876,14 @@ int64_t swr_get_delay(struct SwrContext *s, int64_t base){
     }
 }
 
+int64_t swr_get_filter_delay(struct SwrContext *s, int64_t base){
+    if (!s->resample)
+        return 0;
+    if (!s->resampler->get_filter_delay)
+        return AVERROR(ENOSYS);
+    return s->resampler->get_filter_delay(s, base);
+}
+
 int swr_get_out_samples(struct SwrContext *s, int in_samples)
 {
     int64_t out_samples;
@@ -462,6 +462,22 @@ int swr_inject_silence(struct SwrContext *s, int count);
  */
 int64_t swr_get_delay(struct SwrContext *s, int64_t base);
 
+/**
+ * Get the algorithmic delay of the resampling filter.
+ *
+ * This is the amount of future input the filter needs to produce an output
+ * sample, which is the minimal latency resampling adds to a live stream.
+ * It does not change during conversion, unlike swr_get_delay() it does not
+ * include the buffered samples.
+ *
+ * @param s     initialized swr context
+ * @param base  timebase in which the returned delay will be, like for
+ *              swr_get_delay()
+ * @returns     the delay in 1 / @c base units, 0 if no resampling is done,
+ *              AVERROR(ENOSYS) if the resampling engine cannot tell
+ */
+int64_t swr_get_filter_delay(struct SwrContext *s, int64_t base);
+
 /**
  * Find an upper bound on the number of samples that the next swr_convert
  * call will output, if called with in_samples of input samples. This
@@ -77,6 +77,10 @@ typedef int     (* set_compensation_func)(struct ResampleContext *c, int sample_
 typedef int64_t (* get_delay_func)(struct SwrContext *s, int64_t base);
 typedef int     (* invert_initial_buffer_func)(struct ResampleContext *c, AudioData *dst, const AudioData *src, int src_size, int *dst_idx, int *dst_count);
 typedef int64_t (* get_out_samples_func)(struct SwrContext *s, int in_samples);
+typedef int64_t (* get_filter_delay_func)(struct SwrContext *s, int64_t base);
+
+/* filter_size used by the low_delay option */
+#define SWR_LOW_DELAY_FILTER_SIZE 16
 
 struct Resampler {
   resample_init_func            init;
@@ -87,6 +91,7 @@ struct Resampler {
   get_delay_func                get_delay;
   invert_initial_buffer_func    invert_initial_buffer;
   get_out_samples_func          get_out_samples;
+  get_filter_delay_func         get_filter_delay;
 };
 
 extern struct Resampler const swri_resampler;
@@ -128,6 +133,7 @@ struct SwrContext {
     int phase_shift;                                /**< log2 of the number of entries in the resampling polyphase filterbank */
     int linear_interp;                              /**< if 1 then the resampling FIR filter will be linearly interpolated */
     int exact_rational;                             /**< if 1 then enable non power of 2 phase_count */
+    int low_delay;                                  /**< if 1 then use short filters for integer upsampling ratios */
     double cutoff;                                  /**< resampling cutoff frequency (swr: 6dB point; soxr: 0dB point). 1.0 corresponds to half the output sample rate */
     int filter_type;                                /**< swr resampling filter type */
     double kaiser_beta;                                /**< swr beta value for Kaiser window (only applicable if filter_type == AV_FILTER_TYPE_KAISER) */
@@ -30,6 +30,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
+#include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "config.h"
 #include "rgb2rgb.h"
@@ -228,14 +229,20 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+/**
+ * Scale a slice of the source, outputting the destination lines from
+ * dstSliceY up to dstSliceY + dstSliceH that it provides the input for.
+ */
+static int swscale_band(SwsContext *c, const uint8_t *src[],
+                        int srcStride[], int srcSliceY,
+                        int srcSliceH, uint8_t *dst[], int dstStride[],
+                        int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
     const int dstW                   = c->dstW;
     const int dstH                   = c->dstH;
+    const int dstEnd                 = dstSliceY + dstSliceH;
 
     const enum AVPixelFormat dstFormat = c->dstFormat;
     const int flags                  = c->flags;
@@ -337,7 +344,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -354,8 +361,8 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             srcSliceY, srcSliceH, chrSrcSliceY, chrSrcSliceH, 1);
 
     ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
-            dstY, dstH, dstY >> c->chrDstVSubSample,
-            AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
+            dstY, dstEnd - dstY, dstY >> c->chrDstVSubSample,
+            AV_CEIL_RSHIFT(dstEnd, c->chrDstVSubSample) - (dstY >> c->chrDstVSubSample), 0);
     if (srcSliceY == 0) {
         hout_slice->plane[0].sliceY = lastInLumBuf + 1;
         hout_slice->plane[1].sliceY = lastInChrBuf + 1;
@@ -369,7 +376,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -531,6 +538,70 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_band(c, src, srcStride, srcSliceY, srcSliceH,
+                        dst, dstStride, 0, c->dstH);
+}
+
+/* bands start on a multiple of this, which is a multiple of the
+ * vertical chroma subsampling of all formats */
+#define SLICE_ALIGN 16
+
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext *c      = parent->slice_ctx[threadnr];
+    const int nb_rows  = c->dstH / SLICE_ALIGN;
+    const int start    = nb_rows *  jobnr      / nb_jobs * SLICE_ALIGN;
+    const int end      = jobnr == nb_jobs - 1 ? c->dstH :
+                         nb_rows * (jobnr + 1) / nb_jobs * SLICE_ALIGN;
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    if (end <= start)
+        return;
+
+    /* the scalers may modify them */
+    memcpy(src,       parent->slice_src,       sizeof(src));
+    memcpy(srcStride, parent->slice_srcStride, sizeof(srcStride));
+    memcpy(dst,       parent->slice_dst,       sizeof(dst));
+    memcpy(dstStride, parent->slice_dstStride, sizeof(dstStride));
+
+    /* the whole source is available, the vertical filter of each band
+     * reads the source lines it needs on both sides of it */
+    swscale_band(c, src, srcStride, 0, c->srcH, dst, dstStride,
+                 start, end - start);
+}
+
+static int scale_threaded(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst[], int dstStride[])
+{
+    int i;
+
+    memcpy(c->slice_src,       src,       sizeof(c->slice_src));
+    memcpy(c->slice_srcStride, srcStride, sizeof(c->slice_srcStride));
+    memcpy(c->slice_dst,       dst,       sizeof(c->slice_dst));
+    memcpy(c->slice_dstStride, dstStride, sizeof(c->slice_dstStride));
+
+    if (usePal(c->srcFormat)) {
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            memcpy(c->slice_ctx[i]->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+            memcpy(c->slice_ctx[i]->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+        }
+    }
+
+    avpriv_slicethread_execute(c->slicethread,
+                               av_clip(c->dstH / SLICE_ALIGN, 1, c->nb_slice_ctx), 0);
+
+    c->dstY = c->dstH;
+    return c->dstH;
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -977,7 +1048,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    if (c->slicethread && srcSliceY_internal == 0 && srcSliceH == c->srcH)
+        ret = scale_threaded(c, src2, srcStride2, dst2, dstStride2);
+    else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
@@ -994,3 +1068,112 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     av_free(rgb0_tmp);
     return ret;
 }
+
+static int frame_ctx_init(SwsContext *c, const SwsFrameParams *p)
+{
+    SwsContext *s;
+    int ret;
+
+    sws_freeContext(c->frame_ctx);
+    c->frame_ctx = NULL;
+
+    s = sws_alloc_context();
+    if (!s)
+        return AVERROR(ENOMEM);
+    ret = av_opt_copy((void*)s, (void*)c);
+    if (ret < 0)
+        goto fail;
+
+    s->srcW      = p->src_w;
+    s->srcH      = p->src_h;
+    s->srcFormat = p->src_format;
+    s->srcRange  = p->src_range;
+    s->dstW      = p->dst_w;
+    s->dstH      = p->dst_h;
+    s->dstFormat = p->dst_format;
+    s->dstRange  = p->dst_range;
+    s->flags     = p->flags;
+    s->param[0]  = p->param[0];
+    s->param[1]  = p->param[1];
+
+    ret = sws_init_context(s, NULL, NULL);
+    if (ret < 0)
+        goto fail;
+
+    /* the default matrix is BT.601, which the unknown colorspaces get too,
+     * like in vf_scale; the call fails harmlessly for YUV to YUV */
+    if (p->src_colorspace != AVCOL_SPC_UNSPECIFIED ||
+        p->dst_colorspace != AVCOL_SPC_UNSPECIFIED)
+        sws_setColorspaceDetails(s, sws_getCoefficients(p->src_colorspace), p->src_range,
+                                 sws_getCoefficients(p->dst_colorspace), p->dst_range,
+                                 0, 1 << 16, 1 << 16);
+
+    c->frame_ctx = s;
+    /* copied with memcpy() so that the padding compares equal too */
+    memcpy(&c->frame_params, p, sizeof(*p));
+    return 0;
+fail:
+    sws_freeContext(s);
+    return ret;
+}
+
+int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
+{
+    SwsFrameParams p;
+    int ret;
+
+    if (!av_pix_fmt_desc_get(src->format) || !av_pix_fmt_desc_get(dst->format) ||
+        src->width <= 0 || src->height <= 0 ||
+        dst->width <= 0 || dst->height <= 0 || !src->data[0]) {
+        av_log(c, AV_LOG_ERROR, "Invalid frame parameters\n");
+        return AVERROR(EINVAL);
+    }
+
+    memset(&p, 0, sizeof(p));
+    p.src_w      = src->width;
+    p.src_h      = src->height;
+    p.src_format = src->format;
+    p.src_range  = src->color_range == AVCOL_RANGE_JPEG;
+    p.dst_w      = dst->width;
+    p.dst_h      = dst->height;
+    p.dst_format = dst->format;
+    p.dst_range  = dst->color_range == AVCOL_RANGE_JPEG;
+    p.flags      = c->flags;
+    p.param[0]   = c->param[0];
+    p.param[1]   = c->param[1];
+    p.src_h_chr_pos = c->src_h_chr_pos;
+    p.src_v_chr_pos = c->src_v_chr_pos;
+    p.dst_h_chr_pos = c->dst_h_chr_pos;
+    p.dst_v_chr_pos = c->dst_v_chr_pos;
+    p.dither        = c->dither;
+    p.gamma_flag    = c->gamma_flag;
+    p.alphablend    = c->alphablend;
+    p.nb_threads    = c->nb_threads;
+
+    /* a destination of unknown colorspace keeps the source one */
+    p.src_colorspace = src->colorspace;
+    p.dst_colorspace = dst->colorspace != AVCOL_SPC_UNSPECIFIED ? dst->colorspace
+                                                                : src->colorspace;
+    if (p.src_colorspace == AVCOL_SPC_RGB || p.src_colorspace == AVCOL_SPC_RESERVED ||
+        p.src_colorspace > AVCOL_SPC_BT2020_CL)
+        p.src_colorspace = AVCOL_SPC_BT470BG;
+    if (p.dst_colorspace == AVCOL_SPC_RGB || p.dst_colorspace == AVCOL_SPC_RESERVED ||
+        p.dst_colorspace > AVCOL_SPC_BT2020_CL)
+        p.dst_colorspace = AVCOL_SPC_BT470BG;
+
+    if (!c->frame_ctx || memcmp(&c->frame_params, &p, sizeof(p))) {
+        ret = frame_ctx_init(c, &p);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!dst->data[0]) {
+        ret = av_frame_get_buffer(dst, 0);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = sws_scale(c->frame_ctx, (const uint8_t * const *)src->data,
+                    src->linesize, 0, src->height, dst->data, dst->linesize);
+    return ret < 0 ? ret : 0;
+}
@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #include "libavutil/avutil.h"
+#include "libavutil/frame.h"
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "version.h"
@@ -218,6 +219,30 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
               const int srcStride[], int srcSliceY, int srcSliceH,
               uint8_t *const dst[], const int dstStride[]);
 
+/**
+ * Scale a whole frame, setting up the scaler for the frame parameters.
+ *
+ * The sizes, pixel formats, color ranges and colorspaces are taken from the
+ * frames, the other options (flags, param, chroma positions, dither, threads,
+ * ...) from c, which serves as a template and does not need to be
+ * initialized. The scaler is set up again when any of these change, so c can
+ * be reused across resolution and format switches and its options may be
+ * changed between calls; the filter coefficients are shared with the other
+ * contexts built for the same sizes.
+ *
+ * A destination frame with an unspecified colorspace gets the one of the
+ * source; unspecified and unsupported colorspaces use the default (BT.601)
+ * matrix. Brightness, contrast and saturation are not adjustable this way.
+ *
+ * @param c   the scaling context, allocated with sws_alloc_context() or
+ *            sws_getContext()
+ * @param dst the destination frame; width, height and format must be set,
+ *            its buffers are allocated if it has none
+ * @param src the source frame
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src);
+
 /**
  * @param dstRange flag indicating the while-black range of the output (1=jpeg / 0=mpeg)
  * @param srcRange flag indicating the while-black range of the input (1=jpeg / 0=mpeg)
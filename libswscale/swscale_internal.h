@@ -31,6 +31,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/ppc/util_altivec.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
@@ -273,6 +274,21 @@ typedef void (*yuv2anyX_fn)(struct SwsContext *c, const int16_t *lumFilter,
                             const int16_t **alpSrc, uint8_t **dest,
                             int dstW, int y);
 
+/* Parameters of the frames last scaled by sws_scale_frame(), and the
+ * options of the template context that the scaler was set up with. */
+typedef struct SwsFrameParams {
+    int src_w, src_h, src_format, src_range, src_colorspace;
+    int dst_w, dst_h, dst_format, dst_range, dst_colorspace;
+    int flags;
+    double param[2];
+    int src_h_chr_pos, src_v_chr_pos;
+    int dst_h_chr_pos, dst_v_chr_pos;
+    int dither;
+    int gamma_flag;
+    int alphablend;
+    int nb_threads;
+} SwsFrameParams;
+
 struct SwsSlice;
 struct SwsFilterDescriptor;
 
@@ -321,6 +337,21 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields allow scaling whole pictures in parallel, each
+     * thread scaling a band of the destination with its own context.
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    const uint8_t *slice_src[4];  ///< Picture being scaled by the threads.
+    int slice_srcStride[4];
+    uint8_t *slice_dst[4];
+    int slice_dstStride[4];
+
+    struct SwsContext *frame_ctx; ///< Context used by sws_scale_frame(), set up for frame_params.
+    SwsFrameParams frame_params;
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -830,6 +861,13 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+/**
+ * Scale one band of the destination picture stored in the slice_* fields
+ * of priv, with the context of the thread; called by the slice threads.
+ */
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
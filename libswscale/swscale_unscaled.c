@@ -237,6 +237,60 @@ static int planarToP010Wrapper(SwsContext *c, const uint8_t *src8[],
     return srcSliceH;
 }
 
+static int p010ToPlanarWrapper(SwsContext *c, const uint8_t *src8[],
+                               int srcStride[], int srcSliceY,
+                               int srcSliceH, uint8_t *dstParam[],
+                               int dstStride[])
+{
+    const uint16_t *srcY  = (const uint16_t *)src8[0];
+    const uint16_t *srcUV = (const uint16_t *)src8[1];
+    uint8_t *dstY = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstU = dstParam[1] + dstStride[1] * srcSliceY / 2;
+    uint8_t *dstV = dstParam[2] + dstStride[2] * srcSliceY / 2;
+    const int chrW = AV_CEIL_RSHIFT(c->srcW, 1);
+    int x, y;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2));
+
+    for (y = 0; y < srcSliceH; y++) {
+        if (c->dstFormat == AV_PIX_FMT_YUV420P) {
+            /* dithered like planarCopyWrapper() does from 10 to 8 bits */
+            const uint8_t *dither = dithers[1][(srcSliceY + y) & 7];
+            for (x = 0; x < c->srcW; x++)
+                dstY[x] = ((srcY[x] >> 6) + dither[x & 7]) * 511 >> 11;
+            if (!(y & 1)) {
+                dither = dithers[1][((srcSliceY + y) >> 1) & 7];
+                for (x = 0; x < chrW; x++) {
+                    dstU[x] = ((srcUV[2 * x    ] >> 6) + dither[x & 7]) * 511 >> 11;
+                    dstV[x] = ((srcUV[2 * x + 1] >> 6) + dither[x & 7]) * 511 >> 11;
+                }
+            }
+        } else {
+            uint16_t *dstY16 = (uint16_t *)dstY;
+            uint16_t *dstU16 = (uint16_t *)dstU;
+            uint16_t *dstV16 = (uint16_t *)dstV;
+            for (x = 0; x < c->srcW; x++)
+                dstY16[x] = srcY[x] >> 6;
+            if (!(y & 1)) {
+                for (x = 0; x < chrW; x++) {
+                    dstU16[x] = srcUV[2 * x    ] >> 6;
+                    dstV16[x] = srcUV[2 * x + 1] >> 6;
+                }
+            }
+        }
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0];
+
+        if (!(y & 1)) {
+            srcUV += srcStride[1] / 2;
+            dstU  += dstStride[1];
+            dstV  += dstStride[2];
+        }
+    }
+
+    return srcSliceH;
+}
+
 #if AV_HAVE_BIGENDIAN
 #define output_pixel(p, v) do { \
         uint16_t *pp = (p); \
@@ -1727,6 +1781,11 @@ void ff_get_unscaled_swscale(SwsContext *c)
         dstFormat == AV_PIX_FMT_P010LE) {
         c->swscale = planar8ToP01xleWrapper;
     }
+    /* p010_to_yuv420p(10) */
+    if (srcFormat == AV_PIX_FMT_P010 &&
+        (dstFormat == AV_PIX_FMT_YUV420P || dstFormat == AV_PIX_FMT_YUV420P10)) {
+        c->swscale = p010ToPlanarWrapper;
+    }
 
     if (srcFormat == AV_PIX_FMT_YUV410P && !(dstH & 3) &&
         (dstFormat == AV_PIX_FMT_YUV420P || dstFormat == AV_PIX_FMT_YUVA420P) &&
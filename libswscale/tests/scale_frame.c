@@ -0,0 +1,188 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Scale frames of changing sizes and formats with one context through
+ * sws_scale_frame(), changing the frame colorspace and the chroma position
+ * option of the template context on the way, and compare each result with
+ * the output of a context created for just that conversion. The reference contexts are given
+ * identity filter vectors, so that their coefficients are computed again
+ * instead of being taken from the filter cache.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#define FLAGS (SWS_BICUBIC | SWS_ACCURATE_RND | SWS_BITEXACT)
+
+static const struct {
+    int src_w, src_h;
+    enum AVPixelFormat src_format;
+    int dst_w, dst_h;
+    enum AVPixelFormat dst_format;
+    enum AVColorSpace colorspace;
+    int src_v_chr_pos;
+} tests[] = {
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED, -513 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED, -513 },
+    {  96, 64, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED, -513 },
+    {  64, 48, AV_PIX_FMT_NV12,    48, 36, AV_PIX_FMT_YUV444P, AVCOL_SPC_UNSPECIFIED, -513 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED, -513 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_BT709,       -513 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_BT709,          0 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED,    0 },
+    {  64, 48, AV_PIX_FMT_YUV420P, 80, 60, AV_PIX_FMT_GRAY8,   AVCOL_SPC_UNSPECIFIED, -513 },
+    { 160, 90, AV_PIX_FMT_RGB24,   80, 60, AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709,       -513 },
+    {  96, 64, AV_PIX_FMT_YUV420P, 32, 24, AV_PIX_FMT_RGB24,   AVCOL_SPC_UNSPECIFIED, -513 },
+};
+
+static AVFrame *alloc_frame(int w, int h, enum AVPixelFormat format)
+{
+    AVFrame *frame = av_frame_alloc();
+
+    if (!frame)
+        return NULL;
+    frame->width  = w;
+    frame->height = h;
+    frame->format = format;
+    if (av_frame_get_buffer(frame, 0) < 0)
+        av_frame_free(&frame);
+    return frame;
+}
+
+static void fill_frame(AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    int p, x, y;
+
+    for (p = 0; p < 4 && frame->data[p]; p++) {
+        int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                 : frame->height;
+        int w = av_image_get_linesize(frame->format, frame->width, p);
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++)
+                frame->data[p][y * frame->linesize[p] + x] = x * 7 + y * 13 + p * 71;
+    }
+}
+
+static int frames_differ(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    int p, y;
+
+    for (p = 0; p < 4 && a->data[p]; p++) {
+        int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h)
+                                 : a->height;
+        int w = av_image_get_linesize(a->format, a->width, p);
+        for (y = 0; y < h; y++)
+            if (memcmp(a->data[p] + y * a->linesize[p],
+                       b->data[p] + y * b->linesize[p], w))
+                return 1;
+    }
+    return 0;
+}
+
+static int scale_reference(AVFrame *dst, const AVFrame *src, int src_v_chr_pos)
+{
+    SwsVector *vec = sws_getIdentityVec();
+    SwsFilter filter = { vec, vec, vec, vec };
+    struct SwsContext *sws = sws_alloc_context();
+    const int *coeffs = sws_getCoefficients(src->colorspace);
+    int ret;
+
+    if (!vec || !sws) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    av_opt_set_int(sws, "srcw",          src->width,    0);
+    av_opt_set_int(sws, "srch",          src->height,   0);
+    av_opt_set_int(sws, "src_format",    src->format,   0);
+    av_opt_set_int(sws, "dstw",          dst->width,    0);
+    av_opt_set_int(sws, "dsth",          dst->height,   0);
+    av_opt_set_int(sws, "dst_format",    dst->format,   0);
+    av_opt_set_int(sws, "sws_flags",     FLAGS,         0);
+    av_opt_set_int(sws, "src_v_chr_pos", src_v_chr_pos, 0);
+    if ((ret = sws_init_context(sws, &filter, NULL)) < 0)
+        goto end;
+    if (src->colorspace != AVCOL_SPC_UNSPECIFIED)
+        sws_setColorspaceDetails(sws, coeffs, 0, coeffs, 0, 0, 1 << 16, 1 << 16);
+    ret = sws_scale(sws, (const uint8_t * const *)src->data, src->linesize,
+                    0, src->height, dst->data, dst->linesize);
+end:
+    sws_freeVec(vec);
+    sws_freeContext(sws);
+    return ret < 0 ? ret : 0;
+}
+
+int main(void)
+{
+    struct SwsContext *sws = sws_alloc_context();
+    AVFrame *src = NULL, *dst = NULL, *ref = NULL;
+    int i, ret = 0;
+
+    if (!sws || (ret = av_opt_set_int(sws, "sws_flags", FLAGS, 0)) < 0)
+        goto end;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        src = alloc_frame(tests[i].src_w, tests[i].src_h, tests[i].src_format);
+        dst = av_frame_alloc();
+        ref = alloc_frame(tests[i].dst_w, tests[i].dst_h, tests[i].dst_format);
+        if (!src || !dst || !ref) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        fill_frame(src);
+        src->colorspace = tests[i].colorspace;
+        if ((ret = av_opt_set_int(sws, "src_v_chr_pos", tests[i].src_v_chr_pos, 0)) < 0)
+            goto end;
+
+        /* the buffers of dst are allocated by sws_scale_frame() */
+        dst->width  = tests[i].dst_w;
+        dst->height = tests[i].dst_h;
+        dst->format = tests[i].dst_format;
+        if ((ret = sws_scale_frame(sws, dst, src)) < 0 ||
+            (ret = scale_reference(ref, src, tests[i].src_v_chr_pos)) < 0)
+            goto end;
+
+        printf("%dx%d %s %s chr_pos %d -> %dx%d %s: %s\n",
+               src->width, src->height, av_get_pix_fmt_name(src->format),
+               av_color_space_name(src->colorspace), tests[i].src_v_chr_pos,
+               dst->width, dst->height, av_get_pix_fmt_name(dst->format),
+               frames_differ(dst, ref) ? "differs from a new context"
+                                       : "identical to a new context");
+
+        av_frame_free(&src);
+        av_frame_free(&dst);
+        av_frame_free(&ref);
+    }
+
+end:
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    av_frame_free(&ref);
+    sws_freeContext(sws);
+    return ret < 0;
+}
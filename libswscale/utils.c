@@ -49,6 +49,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "libavutil/aarch64/cpu.h"
 #include "libavutil/ppc/cpu.h"
 #include "libavutil/x86/asm.h"
@@ -715,6 +716,171 @@ fail:
     return ret;
 }
 
+/* Filters are shared between contexts, as computing the wide ones is slow
+ * and the same ones are requested again when a stream switches back and
+ * forth between resolutions or a context is rebuilt for a new format. */
+#define FILTER_CACHE_MAX_SIZE (8 << 20)
+
+typedef struct FilterCacheKey {
+    int xInc, srcW, dstW, filterAlign, one, flags, cpu_flags, srcPos, dstPos;
+    double param[2];
+} FilterCacheKey;
+
+typedef struct FilterCacheEntry {
+    struct FilterCacheEntry *next;
+    FilterCacheKey key;
+    int16_t *filter;
+    int32_t *filter_pos;
+    int filter_size;
+    size_t size;
+} FilterCacheEntry;
+
+static FilterCacheEntry *filter_cache; ///< most recently used first
+static AVMutex filter_cache_mutex;
+static AVOnce filter_cache_once = AV_ONCE_INIT;
+
+static av_cold void filter_cache_init(void)
+{
+    ff_mutex_init(&filter_cache_mutex, NULL);
+}
+
+static void filter_cache_free_entry(FilterCacheEntry *e)
+{
+    av_free(e->filter);
+    av_free(e->filter_pos);
+    av_free(e);
+}
+
+/**
+ * Copy the cached filter for key into newly allocated arrays. Like the
+ * ones allocated by initFilter(), they have dstW + 3 entries.
+ * @return 1 if it was found, 0 otherwise
+ */
+static int filter_cache_get(const FilterCacheKey *key, int16_t **filter,
+                            int32_t **filter_pos, int *filter_size)
+{
+    FilterCacheEntry **p, *e;
+    int found = 0;
+
+    ff_mutex_lock(&filter_cache_mutex);
+    for (p = &filter_cache; (e = *p); p = &e->next) {
+        if (memcmp(&e->key, key, sizeof(*key)))
+            continue;
+        *filter     = av_memdup(e->filter, (key->dstW + 3) * e->filter_size *
+                                           sizeof(**filter));
+        *filter_pos = av_memdup(e->filter_pos, (key->dstW + 3) *
+                                               sizeof(**filter_pos));
+        if (!*filter || !*filter_pos) {
+            av_freep(filter);
+            av_freep(filter_pos);
+            break;
+        }
+        *filter_size = e->filter_size;
+        *p           = e->next;
+        e->next      = filter_cache;
+        filter_cache = e;
+        found        = 1;
+        break;
+    }
+    ff_mutex_unlock(&filter_cache_mutex);
+    return found;
+}
+
+static void filter_cache_add(const FilterCacheKey *key, const int16_t *filter,
+                             const int32_t *filter_pos, int filter_size)
+{
+    size_t size = (key->dstW + 3) * (filter_size * sizeof(*filter) +
+                                     sizeof(*filter_pos));
+    FilterCacheEntry **p, *e;
+
+    if (size > FILTER_CACHE_MAX_SIZE)
+        return;
+    e = av_mallocz(sizeof(*e));
+    if (!e)
+        return;
+    /* copied with memcpy() so that the padding compares equal too */
+    memcpy(&e->key, key, sizeof(*key));
+    e->filter      = av_memdup(filter, (key->dstW + 3) * filter_size *
+                                       sizeof(*filter));
+    e->filter_pos  = av_memdup(filter_pos, (key->dstW + 3) *
+                                           sizeof(*filter_pos));
+    e->filter_size = filter_size;
+    e->size        = size;
+    if (!e->filter || !e->filter_pos) {
+        filter_cache_free_entry(e);
+        return;
+    }
+
+    ff_mutex_lock(&filter_cache_mutex);
+    /* another thread may have added the same filter in the meantime */
+    for (p = &filter_cache; *p; p = &(*p)->next) {
+        if (!memcmp(&(*p)->key, key, sizeof(*key))) {
+            ff_mutex_unlock(&filter_cache_mutex);
+            filter_cache_free_entry(e);
+            return;
+        }
+    }
+    e->next      = filter_cache;
+    filter_cache = e;
+
+    /* drop the least recently used filters beyond the size limit */
+    size = 0;
+    for (p = &filter_cache; *p; p = &(*p)->next) {
+        if (size + (*p)->size > FILTER_CACHE_MAX_SIZE)
+            break;
+        size += (*p)->size;
+    }
+    while ((e = *p)) {
+        *p = e->next;
+        filter_cache_free_entry(e);
+    }
+    ff_mutex_unlock(&filter_cache_mutex);
+}
+
+/**
+ * initFilter() with the result shared between all contexts. Filters built
+ * from user supplied vectors are not cached.
+ */
+static av_cold int initCachedFilter(int16_t **outFilter, int32_t **filterPos,
+                                    int *outFilterSize, int xInc, int srcW,
+                                    int dstW, int filterAlign, int one,
+                                    int flags, int cpu_flags,
+                                    SwsVector *srcFilter, SwsVector *dstFilter,
+                                    double param[2], int srcPos, int dstPos)
+{
+    FilterCacheKey key;
+    int ret;
+
+    if (srcFilter || dstFilter)
+        return initFilter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                          dstW, filterAlign, one, flags, cpu_flags, srcFilter,
+                          dstFilter, param, srcPos, dstPos);
+
+    memset(&key, 0, sizeof(key));
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+
+    ff_thread_once(&filter_cache_once, filter_cache_init);
+    if (filter_cache_get(&key, outFilter, filterPos, outFilterSize))
+        return 0;
+
+    ret = initFilter(outFilter, filterPos, outFilterSize, xInc, srcW, dstW,
+                     filterAlign, one, flags, cpu_flags, NULL, NULL, param,
+                     srcPos, dstPos);
+    if (ret >= 0)
+        filter_cache_add(&key, *outFilter, *filterPos, *outFilterSize);
+    return ret;
+}
+
 static void fill_rgb2yuv_table(SwsContext *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -852,6 +1018,7 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -891,6 +1058,14 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->dstFormatBpp = av_get_bits_per_pixel(desc_dst);
     c->srcFormatBpp = av_get_bits_per_pixel(desc_src);
 
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        int ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                           table, dstRange, brightness,
+                                           contrast, saturation);
+        if (ret < 0)
+            return ret;
+    }
+
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
@@ -1150,8 +1325,8 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
-av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
-                             SwsFilter *dstFilter)
+static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
+                                          SwsFilter *dstFilter)
 {
     int i;
     int usesVFilter, usesHFilter;
@@ -1647,7 +1822,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                                     PPC_ALTIVEC(cpu_flags) ? 8 :
                                     have_neon(cpu_flags)   ? 8 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = initCachedFilter(&c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
@@ -1656,7 +1831,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                            get_local_pos(c, 0, 0, 0),
                            get_local_pos(c, 0, 0, 0))) < 0)
                 goto fail;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = initCachedFilter(&c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1674,7 +1849,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                                 PPC_ALTIVEC(cpu_flags) ? 8 :
                                 have_neon(cpu_flags)   ? 2 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = initCachedFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
@@ -1682,7 +1857,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                        get_local_pos(c, 0, 0, 1),
                        get_local_pos(c, 0, 0, 1))) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = initCachedFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
@@ -1861,6 +2036,65 @@ SwsContext *sws_alloc_set_opts(int srcW, int srcH, enum AVPixelFormat srcFormat,
     return c;
 }
 
+static av_cold int context_init_threaded(SwsContext *c,
+                                         SwsFilter *src_filter, SwsFilter *dst_filter)
+{
+    int i, ret;
+
+    /* Only the scaler proper, which has filter descriptors, works on
+     * bands. The unscaled converters handle the edges of slices like
+     * those of the picture, and cascaded scalers and error diffusion
+     * carry state from one line to the next. */
+    if (!c->desc || c->cascaded_context[0] || c->dither == SWS_DITHER_ED)
+        return 0;
+
+    ret = avpriv_slicethread_create(&c->slicethread, (void*)c,
+                                    ff_sws_slice_worker, NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret == 1) {
+        avpriv_slicethread_free(&c->slicethread);
+        return 0;
+    }
+
+    c->slice_ctx = av_mallocz_array(ret, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+    c->nb_slice_ctx = ret;
+
+    /* the options of c are final now, the contexts of the bands get the
+     * same scaler */
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        c->slice_ctx[i] = sws_alloc_context();
+        if (!c->slice_ctx[i])
+            return AVERROR(ENOMEM);
+
+        ret = av_opt_copy((void*)c->slice_ctx[i], (void*)c);
+        if (ret < 0)
+            return ret;
+        c->slice_ctx[i]->nb_threads = 1;
+        c->slice_ctx[i]->flags     &= ~SWS_PRINT_INFO;
+
+        ret = sws_init_single_context(c->slice_ctx[i], src_filter, dst_filter);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
+                             SwsFilter *dstFilter)
+{
+    int ret = sws_init_single_context(c, srcFilter, dstFilter);
+
+    if (ret < 0 || c->nb_threads == 1)
+        return ret;
+    return context_init_threaded(c, srcFilter, dstFilter);
+}
+
 SwsContext *sws_getContext(int srcW, int srcH, enum AVPixelFormat srcFormat,
                            int dstW, int dstH, enum AVPixelFormat dstFormat,
                            int flags, SwsFilter *srcFilter,
@@ -2287,6 +2521,12 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    avpriv_slicethread_free(&c->slicethread);
+    sws_freeContext(c->frame_ctx);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
@@ -2353,6 +2593,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
                                              SWS_PARAM_DEFAULT };
     int64_t src_h_chr_pos = -513, dst_h_chr_pos = -513,
             src_v_chr_pos = -513, dst_v_chr_pos = -513;
+    int64_t threads = 1;
 
     if (!param)
         param = default_param;
@@ -2372,6 +2613,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
         av_opt_get_int(context, "src_v_chr_pos", 0, &src_v_chr_pos);
         av_opt_get_int(context, "dst_h_chr_pos", 0, &dst_h_chr_pos);
         av_opt_get_int(context, "dst_v_chr_pos", 0, &dst_v_chr_pos);
+        av_opt_get_int(context, "threads",       0, &threads);
         sws_freeContext(context);
         context = NULL;
     }
@@ -2393,6 +2635,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
         av_opt_set_int(context, "src_v_chr_pos", src_v_chr_pos, 0);
         av_opt_set_int(context, "dst_h_chr_pos", dst_h_chr_pos, 0);
         av_opt_set_int(context, "dst_v_chr_pos", dst_v_chr_pos, 0);
+        av_opt_set_int(context, "threads",       threads,       0);
 
         if (sws_init_context(context, srcFilter, dstFilter) < 0) {
             sws_freeContext(context);
@@ -2310,17 +2310,29 @@ static void RENAME(extract_even2avg)(const uint8_t *src0, const uint8_t *src1, u
             "psrlw             $8, %%mm7        \n\t"
             "1:                                \n\t"
             "movq  -28(%1, %0, 4), %%mm0        \n\t"
-            "movq  -20(%1, %0, 4), %%mm1        \n\t"
-            "movq  -12(%1, %0, 4), %%mm2        \n\t"
-            "movq   -4(%1, %0, 4), %%mm3        \n\t"
-            PAVGB" -28(%2, %0, 4), %%mm0        \n\t"
-            PAVGB" -20(%2, %0, 4), %%mm1        \n\t"
-            PAVGB" -12(%2, %0, 4), %%mm2        \n\t"
-            PAVGB" - 4(%2, %0, 4), %%mm3        \n\t"
+            "movq  -28(%2, %0, 4), %%mm4        \n\t"
             "pand           %%mm7, %%mm0        \n\t"
+            "pand           %%mm7, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm0        \n\t"
+            "psrlw             $1, %%mm0        \n\t"
+            "movq  -20(%1, %0, 4), %%mm1        \n\t"
+            "movq  -20(%2, %0, 4), %%mm4        \n\t"
             "pand           %%mm7, %%mm1        \n\t"
+            "pand           %%mm7, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm1        \n\t"
+            "psrlw             $1, %%mm1        \n\t"
+            "movq  -12(%1, %0, 4), %%mm2        \n\t"
+            "movq  -12(%2, %0, 4), %%mm4        \n\t"
             "pand           %%mm7, %%mm2        \n\t"
+            "pand           %%mm7, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm2        \n\t"
+            "psrlw             $1, %%mm2        \n\t"
+            "movq   -4(%1, %0, 4), %%mm3        \n\t"
+            "movq   -4(%2, %0, 4), %%mm4        \n\t"
             "pand           %%mm7, %%mm3        \n\t"
+            "pand           %%mm7, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm3        \n\t"
+            "psrlw             $1, %%mm3        \n\t"
             "packuswb       %%mm1, %%mm0        \n\t"
             "packuswb       %%mm3, %%mm2        \n\t"
             "movq           %%mm0, %%mm1        \n\t"
@@ -2412,17 +2424,29 @@ static void RENAME(extract_odd2avg)(const uint8_t *src0, const uint8_t *src1, ui
             "psrlw             $8, %%mm7        \n\t"
             "1:                                \n\t"
             "movq  -28(%1, %0, 4), %%mm0        \n\t"
-            "movq  -20(%1, %0, 4), %%mm1        \n\t"
-            "movq  -12(%1, %0, 4), %%mm2        \n\t"
-            "movq   -4(%1, %0, 4), %%mm3        \n\t"
-            PAVGB" -28(%2, %0, 4), %%mm0        \n\t"
-            PAVGB" -20(%2, %0, 4), %%mm1        \n\t"
-            PAVGB" -12(%2, %0, 4), %%mm2        \n\t"
-            PAVGB" - 4(%2, %0, 4), %%mm3        \n\t"
+            "movq  -28(%2, %0, 4), %%mm4        \n\t"
             "psrlw             $8, %%mm0        \n\t"
+            "psrlw             $8, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm0        \n\t"
+            "psrlw             $1, %%mm0        \n\t"
+            "movq  -20(%1, %0, 4), %%mm1        \n\t"
+            "movq  -20(%2, %0, 4), %%mm4        \n\t"
             "psrlw             $8, %%mm1        \n\t"
+            "psrlw             $8, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm1        \n\t"
+            "psrlw             $1, %%mm1        \n\t"
+            "movq  -12(%1, %0, 4), %%mm2        \n\t"
+            "movq  -12(%2, %0, 4), %%mm4        \n\t"
             "psrlw             $8, %%mm2        \n\t"
+            "psrlw             $8, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm2        \n\t"
+            "psrlw             $1, %%mm2        \n\t"
+            "movq   -4(%1, %0, 4), %%mm3        \n\t"
+            "movq   -4(%2, %0, 4), %%mm4        \n\t"
             "psrlw             $8, %%mm3        \n\t"
+            "psrlw             $8, %%mm4        \n\t"
+            "paddw          %%mm4, %%mm3        \n\t"
+            "psrlw             $1, %%mm3        \n\t"
             "packuswb       %%mm1, %%mm0        \n\t"
             "packuswb       %%mm3, %%mm2        \n\t"
             "movq           %%mm0, %%mm1        \n\t"
@@ -59,6 +59,8 @@ static void free_frame(void *arg)
     av_frame_free(&msg->frame);
 }
 
+static unsigned queue_flags;
+
 static void *sender_thread(void *arg)
 {
     int i, ret = 0;
@@ -66,7 +68,8 @@ static void *sender_thread(void *arg)
 
     av_log(NULL, AV_LOG_INFO, "sender #%d: workload=%d\n", wd->id, wd->workload);
     for (i = 0; i < wd->workload; i++) {
-        if (rand() % wd->workload < wd->workload / 10) {
+        /* the lock-free queues may only be flushed by the receiver */
+        if (!queue_flags && rand() % wd->workload < wd->workload / 10) {
             av_log(NULL, AV_LOG_INFO, "sender #%d: flushing the queue\n", wd->id);
             av_thread_message_flush(wd->queue);
         } else {
@@ -169,10 +172,11 @@ int main(int ac, char **av)
     struct receiver_data *receivers;
     AVThreadMessageQueue *queue = NULL;
 
-    if (ac != 8) {
+    if (ac != 8 && ac != 9) {
         av_log(NULL, AV_LOG_ERROR, "%s <max_queue_size> "
                "<nb_senders> <sender_min_send> <sender_max_send> "
-               "<nb_receivers> <receiver_min_recv> <receiver_max_recv>\n", av[0]);
+               "<nb_receivers> <receiver_min_recv> <receiver_max_recv> "
+               "[mpsc|spsc]\n", av[0]);
         return 1;
     }
 
@@ -183,6 +187,16 @@ int main(int ac, char **av)
     nb_receivers      = atoi(av[5]);
     receiver_min_load = atoi(av[6]);
     receiver_max_load = atoi(av[7]);
+    if (ac == 9) {
+        if (!strcmp(av[8], "mpsc")) {
+            queue_flags = AV_THREAD_MESSAGE_QUEUE_MPSC;
+        } else if (!strcmp(av[8], "spsc")) {
+            queue_flags = AV_THREAD_MESSAGE_QUEUE_SPSC;
+        } else {
+            av_log(NULL, AV_LOG_ERROR, "unknown queue mode %s\n", av[8]);
+            return 1;
+        }
+    }
 
     if (max_queue_size <= 0 ||
         nb_senders <= 0 || sender_min_load <= 0 || sender_max_load <= 0 ||
@@ -190,6 +204,11 @@ int main(int ac, char **av)
         av_log(NULL, AV_LOG_ERROR, "negative values not allowed\n");
         return 1;
     }
+    if ((queue_flags && nb_receivers > 1) ||
+        (queue_flags & AV_THREAD_MESSAGE_QUEUE_SPSC && nb_senders > 1)) {
+        av_log(NULL, AV_LOG_ERROR, "too many threads for the queue mode\n");
+        return 1;
+    }
 
     av_log(NULL, AV_LOG_INFO, "qsize:%d / %d senders sending [%d-%d] / "
            "%d receivers receiving [%d-%d]\n", max_queue_size,
@@ -203,7 +222,8 @@ int main(int ac, char **av)
         goto end;
     }
 
-    ret = av_thread_message_queue_alloc(&queue, max_queue_size, sizeof(struct message));
+    ret = av_thread_message_queue_alloc2(&queue, max_queue_size,
+                                         sizeof(struct message), queue_flags);
     if (ret < 0)
         goto end;
 
@@ -147,6 +147,13 @@ static const struct {
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
 #endif
+#if CONFIG_SWRESAMPLE
+        { "sw_resample", checkasm_check_sw_resample },
+#endif
+#if CONFIG_SWSCALE
+        { "sw_rgb", checkasm_check_sw_rgb },
+        { "sw_scale", checkasm_check_sw_scale },
+#endif
 #if CONFIG_AVUTIL
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
@@ -226,7 +226,49 @@ static void check_idct(void)
     report("idct");
 }
 
+#define STARTCODE_BUF_SIZE 1024
+
+static void check_startcode(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf, [STARTCODE_BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE]);
+    static const int sizes[] = { 0, 1, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 200, 1000 };
+    H264DSPContext h;
+    int i, offset, zero;
+    declare_func(int, const uint8_t *buf, int size);
+
+    ff_h264dsp_init(&h, 8, 1);
+    if (check_func(h.startcode_find_candidate, "startcode_find_candidate")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+            for (offset = 0; offset < 4; offset++) {
+                const uint8_t *src = buf + offset;
+                int size = sizes[i];
+
+                /* no zero at all, a zero inside the buffer, a zero right
+                 * past its end */
+                for (zero = -1; zero <= 1; zero++) {
+                    int pos = zero < 0 ? -1 : zero ? size : rnd() % FFMAX(size, 1);
+                    int ref, new, j;
+
+                    for (j = 0; j < STARTCODE_BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE; j++)
+                        buf[j] = rnd() % 255 + 1;
+                    if (pos >= 0)
+                        buf[offset + pos] = 0;
+
+                    ref = call_ref(src, size);
+                    new = call_new(src, size);
+                    if (FFMIN(ref, size) != FFMIN(new, size))
+                        fail();
+                }
+            }
+        }
+        memset(buf, 1, STARTCODE_BUF_SIZE);
+        bench_new(buf, STARTCODE_BUF_SIZE);
+    }
+    report("startcode");
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
+    check_startcode();
 }
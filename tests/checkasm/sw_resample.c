@@ -0,0 +1,126 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libswresample/resample.h"
+
+#define DST_LEN 250  /* not a multiple of any SIMD width */
+#define SRC_LEN (2 * DST_LEN + 64)
+#define BUF_SIZE ((SRC_LEN + 16) * 8)
+
+static void fill_src(uint8_t *buf, enum AVSampleFormat fmt)
+{
+    int i;
+
+    for (i = 0; i < SRC_LEN + 16; i++) {
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P:
+            ((int16_t *)buf)[i] = rnd();
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            ((float *)buf)[i] = (int32_t)rnd() / (float)INT32_MAX;
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            ((double *)buf)[i] = (int32_t)rnd() / (double)INT32_MAX;
+            break;
+        }
+    }
+}
+
+static int compare_dst(const uint8_t *a, const uint8_t *b, enum AVSampleFormat fmt)
+{
+    switch (fmt) {
+    case AV_SAMPLE_FMT_FLTP:
+        return !float_near_abs_eps_array((const float *)a, (const float *)b,
+                                         1e-5, DST_LEN);
+    case AV_SAMPLE_FMT_DBLP:
+        return !double_near_abs_eps_array((const double *)a, (const double *)b,
+                                          1e-12, DST_LEN);
+    default:
+        return memcmp(a, b, DST_LEN * av_get_bytes_per_sample(fmt));
+    }
+}
+
+static void check_resample(void)
+{
+    static const enum AVSampleFormat fmts[] = {
+        AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+    };
+    /* the low delay upsampling of voice rates, and a generic ratio for
+     * which the filter is interpolated */
+    static const struct {
+        int in_rate, out_rate, filter_size, exact_rational, linear;
+    } cfgs[] = {
+        {  8000, 48000, 16, 1, 0 },
+        { 16000, 48000, 16, 1, 0 },
+        { 44100, 48000, 32, 0, 1 },
+    };
+    LOCAL_ALIGNED_32(uint8_t, src,  [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [BUF_SIZE]);
+    int i, j;
+
+    declare_func(int, ResampleContext *c, void *dst, const void *src, int n,
+                 int update_ctx);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(fmts); i++) {
+        const char *name = av_get_sample_fmt_name(fmts[i]);
+
+        for (j = 0; j < FF_ARRAY_ELEMS(cfgs); j++) {
+            ResampleContext *c;
+
+            c = swri_resampler.init(NULL, cfgs[j].out_rate, cfgs[j].in_rate,
+                                    cfgs[j].filter_size, 10, cfgs[j].linear,
+                                    0, fmts[i], SWR_FILTER_TYPE_KAISER, 9,
+                                    0, 0, cfgs[j].exact_rational);
+            if (!c) {
+                fail();
+                continue;
+            }
+            /* start in the middle of the filter bank as after some input */
+            c->index = rnd() % c->phase_count;
+            c->frac  = cfgs[j].linear ? rnd() % c->src_incr : 0;
+
+            if (check_func(cfgs[j].linear ? c->dsp.resample_linear
+                                          : c->dsp.resample_common,
+                           "resample_%s_%s_%d_%d",
+                           cfgs[j].linear ? "linear" : "common", name,
+                           cfgs[j].in_rate, cfgs[j].out_rate)) {
+                fill_src(src, fmts[i]);
+                memset(dst0, 0, BUF_SIZE);
+                memset(dst1, 0, BUF_SIZE);
+                call_ref(c, dst0, src, DST_LEN, 0);
+                call_new(c, dst1, src, DST_LEN, 0);
+                if (compare_dst(dst0, dst1, fmts[i]))
+                    fail();
+                bench_new(c, dst1, src, DST_LEN, 0);
+            }
+            swri_resampler.free(&c);
+        }
+    }
+    report("resample");
+}
+
+void checkasm_check_sw_resample(void)
+{
+    check_resample();
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libswscale/rgb2rgb.h"
+
+#define WIDTH  75  /* not a multiple of any SIMD width, and odd */
+#define HEIGHT 4
+#define STRIDE (4 * WIDTH + 16)
+#define BUF_SIZE (STRIDE * HEIGHT)
+
+#define randomize_buffers(buf, size)          \
+    do {                                      \
+        int k;                                \
+        for (k = 0; k < size; k++)            \
+            buf[k] = rnd();                   \
+    } while (0)
+
+static void check_interleave_bytes(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [BUF_SIZE]);
+    int w;
+
+    declare_func(void, const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                 int width, int height, int src1Stride, int src2Stride,
+                 int dstStride);
+
+    if (check_func(interleaveBytes, "interleave_bytes")) {
+        for (w = 1; w <= 2 * WIDTH; w += w < 40 ? 13 : 47) {
+            randomize_buffers(src1, BUF_SIZE);
+            randomize_buffers(src2, BUF_SIZE);
+            memset(dst0, 0, BUF_SIZE);
+            memset(dst1, 0, BUF_SIZE);
+            /* odd offsets for unaligned rows */
+            call_ref(src1 + 1, src2 + 3, dst0 + 5, w, HEIGHT, STRIDE / 2 + 1,
+                     STRIDE / 2, STRIDE);
+            call_new(src1 + 1, src2 + 3, dst1 + 5, w, HEIGHT, STRIDE / 2 + 1,
+                     STRIDE / 2, STRIDE);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+        }
+        bench_new(src1, src2, dst1, 2 * WIDTH, HEIGHT, STRIDE / 2, STRIDE / 2,
+                  STRIDE);
+    }
+    report("interleave_bytes");
+}
+
+static void check_deinterleave_bytes(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst10, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst20, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst11, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst21, [BUF_SIZE]);
+    int w;
+
+    declare_func(void, const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                 int width, int height, int srcStride, int dst1Stride,
+                 int dst2Stride);
+
+    if (check_func(deinterleaveBytes, "deinterleave_bytes")) {
+        for (w = 1; w <= 2 * WIDTH; w += w < 40 ? 13 : 47) {
+            randomize_buffers(src, BUF_SIZE);
+            memset(dst10, 0, BUF_SIZE);
+            memset(dst20, 0, BUF_SIZE);
+            memset(dst11, 0, BUF_SIZE);
+            memset(dst21, 0, BUF_SIZE);
+            call_ref(src, dst10, dst20, w, HEIGHT, STRIDE, STRIDE / 2, STRIDE / 2);
+            call_new(src, dst11, dst21, w, HEIGHT, STRIDE, STRIDE / 2, STRIDE / 2);
+            if (memcmp(dst10, dst11, BUF_SIZE) || memcmp(dst20, dst21, BUF_SIZE))
+                fail();
+        }
+        bench_new(src, dst11, dst21, 2 * WIDTH, HEIGHT, STRIDE, STRIDE / 2,
+                  STRIDE / 2);
+    }
+    report("deinterleave_bytes");
+}
+
+static void check_packed_to_yuv420(void)
+{
+    static const char *const names[] = { "yuyvtoyuv420", "uyvytoyuv420" };
+    LOCAL_ALIGNED_32(uint8_t, src,  [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [3 * BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [3 * BUF_SIZE]);
+    int i, w;
+
+    declare_func(void, uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                 const uint8_t *src, int width, int height,
+                 int lumStride, int chromStride, int srcStride);
+
+    for (i = 0; i < 2; i++) {
+        if (!check_func(i ? uyvytoyuv420 : yuyvtoyuv420, "%s", names[i]))
+            continue;
+        for (w = 1; w <= 2 * WIDTH; w += w < 40 ? 13 : 47) {
+            randomize_buffers(src, BUF_SIZE);
+            memset(dst0, 0, 3 * BUF_SIZE);
+            memset(dst1, 0, 3 * BUF_SIZE);
+            call_ref(dst0, dst0 + BUF_SIZE, dst0 + 2 * BUF_SIZE, src, w, HEIGHT,
+                     STRIDE, STRIDE / 2, STRIDE);
+            call_new(dst1, dst1 + BUF_SIZE, dst1 + 2 * BUF_SIZE, src, w, HEIGHT,
+                     STRIDE, STRIDE / 2, STRIDE);
+            if (memcmp(dst0, dst1, 3 * BUF_SIZE))
+                fail();
+        }
+        bench_new(dst1, dst1 + BUF_SIZE, dst1 + 2 * BUF_SIZE, src, 2 * WIDTH,
+                  HEIGHT, STRIDE, STRIDE / 2, STRIDE);
+    }
+    report("packed_to_yuv420");
+}
+
+void checkasm_check_sw_rgb(void)
+{
+    ff_sws_rgb2rgb_init();
+
+    check_interleave_bytes();
+    check_deinterleave_bytes();
+    check_packed_to_yuv420();
+}
@@ -0,0 +1,281 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define SRC_PIXELS 512
+#define DST_PIXELS 301 /* not a multiple of any SIMD width */
+#define MAX_FILTER_WIDTH 40
+#define MAX_VFILTER 16
+/* the SIMD vertical scalers need aligned lines, which may be read past dstW */
+#define VLINE_SIZE FFALIGN(DST_PIXELS + 64, 32)
+
+#define randomize_buffers(buf, size)          \
+    do {                                      \
+        int k;                                \
+        for (k = 0; k < size; k++)            \
+            buf[k] = rnd();                   \
+    } while (0)
+
+static SwsContext *alloc_context(enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt,
+                                 int flags)
+{
+    SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    c->srcFormat = src_fmt;
+    c->dstFormat = dst_fmt;
+    c->srcBpc    = av_pix_fmt_desc_get(src_fmt)->comp[0].depth;
+    c->dstBpc    = av_pix_fmt_desc_get(dst_fmt)->comp[0].depth;
+    if (c->srcBpc < 8)
+        c->srcBpc = 8;
+    c->flags     = flags;
+    return c;
+}
+
+/* Make a filter like initFilter() does: coefficients summing to 1 << 14,
+ * some negative for the wider filters, and the entries past dstW padded. */
+static void make_hfilter(int16_t *filter, int32_t *filter_pos, int size)
+{
+    int i, j;
+
+    for (i = 0; i < DST_PIXELS; i++) {
+        int sum = 0, k = rnd() % size;
+
+        filter_pos[i] = rnd() % (SRC_PIXELS - size);
+        for (j = 0; j < size; j++) {
+            filter[i * size + j] = (1 << 14) / size + (int)(rnd() % 1024) - 512;
+            sum += filter[i * size + j];
+        }
+        filter[i * size + k] += (1 << 14) - sum;
+    }
+    for (i = DST_PIXELS; i < DST_PIXELS + 7; i++) {
+        filter_pos[i] = filter_pos[DST_PIXELS - 1];
+        memcpy(filter + i * size, filter + (DST_PIXELS - 1) * size, size * sizeof(*filter));
+    }
+}
+
+static void check_hscale(void)
+{
+    static const int filter_sizes[] = { 4, 8, 12, 16, 20, 40 };
+    static const struct {
+        enum AVPixelFormat src, dst;
+    } pairs[] = {
+        { AV_PIX_FMT_YUV420P,      AV_PIX_FMT_YUV420P      },
+        { AV_PIX_FMT_YUV420P,      AV_PIX_FMT_YUV420P16LE  },
+        { AV_PIX_FMT_YUV420P10LE,  AV_PIX_FMT_YUV420P      },
+        { AV_PIX_FMT_YUV420P10LE,  AV_PIX_FMT_YUV420P16LE  },
+        { AV_PIX_FMT_YUV420P16LE,  AV_PIX_FMT_YUV420P      },
+        { AV_PIX_FMT_YUV420P16LE,  AV_PIX_FMT_YUV420P16LE  },
+    };
+    LOCAL_ALIGNED_32(uint16_t, src,        [SRC_PIXELS + MAX_FILTER_WIDTH]);
+    LOCAL_ALIGNED_32(int32_t,  dst0,       [DST_PIXELS + 8]);
+    LOCAL_ALIGNED_32(int32_t,  dst1,       [DST_PIXELS + 8]);
+    LOCAL_ALIGNED_32(int16_t,  filter,     [(DST_PIXELS + 7) * MAX_FILTER_WIDTH]);
+    LOCAL_ALIGNED_32(int32_t,  filter_pos, [DST_PIXELS + 7]);
+    int i, j;
+
+    declare_func(void, SwsContext *c, int16_t *dst, int dstW,
+                 const uint8_t *src, const int16_t *filter,
+                 const int32_t *filterPos, int filterSize);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(pairs); i++) {
+        SwsContext *c = alloc_context(pairs[i].src, pairs[i].dst, SWS_BICUBIC);
+        int src_bits  = av_pix_fmt_desc_get(pairs[i].src)->comp[0].depth;
+
+        if (!c) {
+            fail();
+            return;
+        }
+        for (j = 0; j < FF_ARRAY_ELEMS(filter_sizes); j++) {
+            int size = filter_sizes[j];
+            int k;
+
+            c->hLumFilterSize = c->hChrFilterSize = size;
+            ff_getSwsFunc(c);
+            if (!check_func(c->hyScale, "hscale%dto%d_%d", src_bits,
+                            c->dstBpc <= 14 ? 15 : 19, size))
+                continue;
+
+            if (src_bits == 8) {
+                uint8_t *src8 = (uint8_t *)src;
+                for (k = 0; k < 2 * (SRC_PIXELS + MAX_FILTER_WIDTH); k++)
+                    src8[k] = rnd();
+            } else {
+                for (k = 0; k < SRC_PIXELS + MAX_FILTER_WIDTH; k++)
+                    src[k] = rnd() & ((1 << src_bits) - 1);
+            }
+            make_hfilter(filter, filter_pos, size);
+            memset(dst0, 0, sizeof(*dst0) * (DST_PIXELS + 8));
+            memset(dst1, 0, sizeof(*dst1) * (DST_PIXELS + 8));
+
+            call_ref(c, (int16_t *)dst0, DST_PIXELS, (const uint8_t *)src,
+                     filter, filter_pos, size);
+            call_new(c, (int16_t *)dst1, DST_PIXELS, (const uint8_t *)src,
+                     filter, filter_pos, size);
+            if (memcmp(dst0, dst1, DST_PIXELS * (c->dstBpc <= 14 ? 2 : 4)))
+                fail();
+
+            bench_new(c, (int16_t *)dst1, DST_PIXELS, (const uint8_t *)src,
+                      filter, filter_pos, size);
+        }
+        sws_freeContext(c);
+    }
+    report("hscale");
+}
+
+/* vertical scaling to 8 bit with the filter layout of the C code */
+static void check_yuv2planeX(void)
+{
+    static const int filter_sizes[] = { 2, 4, 8, 16 };
+    LOCAL_ALIGNED_32(int16_t, src_pixels, [MAX_VFILTER * VLINE_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, filter,     [MAX_VFILTER]);
+    LOCAL_ALIGNED_32(uint8_t, dst0,       [DST_PIXELS + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst1,       [DST_PIXELS + 32]);
+    LOCAL_ALIGNED_8(uint8_t,  dither,     [8]);
+    const int16_t *src[MAX_VFILTER];
+    SwsContext *c;
+    int i, j, offset;
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    /* SWS_ACCURATE_RND keeps the x86 inline versions, which use another
+     * filter layout, from being selected */
+    c = alloc_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P,
+                      SWS_BICUBIC | SWS_ACCURATE_RND);
+    if (!c) {
+        fail();
+        return;
+    }
+    ff_getSwsFunc(c);
+
+    for (i = 0; i < MAX_VFILTER; i++)
+        src[i] = src_pixels + i * VLINE_SIZE;
+
+    for (j = 0; j < FF_ARRAY_ELEMS(filter_sizes); j++) {
+        int size = filter_sizes[j];
+
+        if (!check_func(c->yuv2planeX, "yuv2planeX_8_%d", size))
+            continue;
+
+        for (offset = 0; offset <= 3; offset += 3) {
+            int sum = 0;
+
+            for (i = 0; i < MAX_VFILTER * VLINE_SIZE; i++)
+                src_pixels[i] = rnd() & 0x7fff;
+            for (i = 0; i < size; i++) {
+                filter[i] = (1 << 12) / size + (int)(rnd() % 256) - 128;
+                sum += filter[i];
+            }
+            filter[rnd() % size] += (1 << 12) - sum;
+            randomize_buffers(dither, 8);
+            memset(dst0, 0, DST_PIXELS + 32);
+            memset(dst1, 0, DST_PIXELS + 32);
+
+            call_ref(filter, size, src, dst0, DST_PIXELS, dither, offset);
+            call_new(filter, size, src, dst1, DST_PIXELS, dither, offset);
+            if (memcmp(dst0, dst1, DST_PIXELS))
+                fail();
+        }
+
+        bench_new(filter, size, src, dst1, DST_PIXELS, dither, 0);
+    }
+    sws_freeContext(c);
+    report("yuv2planeX");
+}
+
+/* vertical scaling to 8 bit with the filter layout of use_mmx_vfilter, the
+ * one of the inline MMX versions; the first of them is the reference. */
+static void check_yuv2yuvX(void)
+{
+    static const int filter_sizes[] = { 2, 4, 8, 16 };
+    LOCAL_ALIGNED_32(int16_t, src_pixels, [MAX_VFILTER * VLINE_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0,       [DST_PIXELS + 64]);
+    LOCAL_ALIGNED_32(uint8_t, dst1,       [DST_PIXELS + 64]);
+    LOCAL_ALIGNED_8(uint8_t,  dither,     [8]);
+    LOCAL_ALIGNED_8(int32_t,  mmx_filter, [4 * (MAX_VFILTER + 1)]);
+    SwsContext *c;
+    int i, j, offset;
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    c = alloc_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, SWS_BICUBIC);
+    if (!c) {
+        fail();
+        return;
+    }
+    ff_getSwsFunc(c);
+    if (!c->use_mmx_vfilter) {
+        sws_freeContext(c);
+        return;
+    }
+
+    for (j = 0; j < FF_ARRAY_ELEMS(filter_sizes); j++) {
+        int size = filter_sizes[j];
+
+        if (!check_func(c->yuv2planeX, "yuv2yuvX_%d", size))
+            continue;
+
+        for (offset = 0; offset <= 8; offset += 8) {
+            int sum = 0;
+
+            for (i = 0; i < MAX_VFILTER * VLINE_SIZE; i++)
+                src_pixels[i] = rnd() & 0x7fff;
+            memset(mmx_filter, 0, 4 * (MAX_VFILTER + 1) * sizeof(*mmx_filter));
+            for (i = 0; i < size; i++) {
+                int coeff = i < size - 1 ? (1 << 12) / size + (int)(rnd() % 256) - 128
+                                         : (1 << 12) - sum;
+                sum += coeff;
+                *(const void **)&mmx_filter[4 * i] = src_pixels + i * VLINE_SIZE;
+                mmx_filter[4 * i + 2] =
+                mmx_filter[4 * i + 3] = (uint16_t)coeff * 0x10001U;
+            }
+            randomize_buffers(dither, 8);
+            memset(dst0, 0, DST_PIXELS + 64);
+            memset(dst1, 0, DST_PIXELS + 64);
+
+            call_ref((const int16_t *)mmx_filter, size, NULL, dst0, DST_PIXELS, dither, offset);
+            call_new((const int16_t *)mmx_filter, size, NULL, dst1, DST_PIXELS, dither, offset);
+            if (memcmp(dst0, dst1, DST_PIXELS))
+                fail();
+        }
+
+        bench_new((const int16_t *)mmx_filter, size, NULL, dst1, DST_PIXELS, dither, 0);
+    }
+    sws_freeContext(c);
+    report("yuv2yuvX");
+}
+
+void checkasm_check_sw_scale(void)
+{
+    check_hscale();
+    check_yuv2planeX();
+    check_yuv2yuvX();
+}
@@ -30,6 +30,16 @@ fate-api-threadmessage: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
 fate-api-threadmessage: CMD = run $(APITESTSDIR)/api-threadmessage-test 3 10 30 50 2 20 40
 fate-api-threadmessage: CMP = null
 
+FATE_API-$(HAVE_THREADS) += fate-api-threadmessage-mpsc
+fate-api-threadmessage-mpsc: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
+fate-api-threadmessage-mpsc: CMD = run $(APITESTSDIR)/api-threadmessage-test 3 10 30 50 1 20 40 mpsc
+fate-api-threadmessage-mpsc: CMP = null
+
+FATE_API-$(HAVE_THREADS) += fate-api-threadmessage-spsc
+fate-api-threadmessage-spsc: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
+fate-api-threadmessage-spsc: CMD = run $(APITESTSDIR)/api-threadmessage-test 3 1 30 50 1 20 40 spsc
+fate-api-threadmessage-spsc: CMP = null
+
 FATE_API_SAMPLES-$(CONFIG_AVFORMAT) += $(FATE_API_SAMPLES_LIBAVFORMAT-yes)
 
 ifdef SAMPLES
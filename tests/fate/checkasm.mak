@@ -18,6 +18,9 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-llviddsp                                  \
                 fate-checkasm-pixblockdsp                               \
                 fate-checkasm-sbrdsp                                    \
+                fate-checkasm-sw_resample                               \
+                fate-checkasm-sw_rgb                                    \
+                fate-checkasm-sw_scale                                  \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-v210enc                                   \
                 fate-checkasm-vf_blend                                  \
@@ -71,6 +71,18 @@ fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=
 FATE_FILTER-$(call ALLYES, AVDEVICE TESTSRC_FILTER) += fate-filter-lavd-testsrc
 fate-filter-lavd-testsrc: CMD = framecrc -f lavfi -i testsrc=r=7:n=2:d=10
 
+FATE_FILTER-$(call ALLYES, AVDEVICE TESTSRC_FILTER FORMAT_FILTER SCALE_FILTER) += fate-filter-scale-p010-yuv420p fate-filter-scale-p010-yuv420p10
+fate-filter-scale-p010-yuv420p:   CMD = framecrc -f lavfi -i testsrc=s=322x242:r=5:d=1,format=p010 -pix_fmt yuv420p
+fate-filter-scale-p010-yuv420p10: CMD = framecrc -f lavfi -i testsrc=s=322x242:r=5:d=1,format=p010 -pix_fmt yuv420p10le
+
+FATE_FILTER-$(call ALLYES, TESTSRC_FILTER DRAWBOX_FILTER SCALE_FILTER SINE_FILTER AMERGE_FILTER) += fate-filter-graphclone
+fate-filter-graphclone: libavfilter/tests/graphclone$(EXESUF)
+fate-filter-graphclone: CMD = run libavfilter/tests/graphclone
+
+FATE_FILTER-$(call ALLYES, TESTSRC_FILTER FORMAT_FILTER SPLIT_FILTER HUE_FILTER HSTACK_FILTER) += fate-filter-stats
+fate-filter-stats: libavfilter/tests/filterstats$(EXESUF)
+fate-filter-stats: CMD = run libavfilter/tests/filterstats
+
 FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER) += fate-filter-testsrc2-yuv420p
 fate-filter-testsrc2-yuv420p: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt yuv420p
 
@@ -113,6 +125,19 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER) += fate-filter-fram
 fate-filter-framerate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=10 -t 1
 fate-filter-framerate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=1 -t 1
 
+# the inputs have the size of a cell and the output format, so that they are
+# copied as is; the 5 fps input is repeated and the fourth cell stays empty
+FATE_FILTER-$(call ALLYES, FORMAT_FILTER MOSAIC_FILTER SMPTEBARS_FILTER TESTSRC2_FILTER) += fate-filter-mosaic
+fate-filter-mosaic: CMD = framemd5 -lavfi "testsrc2=s=160x120:r=10:d=1,format=yuv420p[a];smptebars=s=160x120:r=5:d=1,format=yuv420p[b];[a][b]mosaic=inputs=2:grid=2x2:size=320x240:rate=8" -pix_fmt yuv420p
+
+# The pipelined graph must give the same output as the serial one.
+FILTER_PIPELINE_GRAPH = "testsrc2=s=320x240:r=25:d=2,format=yuv420p,hflip,boxblur=2,negate,vflip,edgedetect=mode=colormix"
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER HFLIP_FILTER BOXBLUR_FILTER NEGATE_FILTER VFLIP_FILTER EDGEDETECT_FILTER) += fate-filter-pipeline-serial fate-filter-pipeline
+fate-filter-pipeline-serial: CMD = framemd5 -filter_complex_threads 4 -lavfi $(FILTER_PIPELINE_GRAPH) -pix_fmt yuv420p
+fate-filter-pipeline: CMD = framemd5 -filter_pipeline -filter_complex_threads 4 -lavfi $(FILTER_PIPELINE_GRAPH) -pix_fmt yuv420p
+fate-filter-pipeline: REF = $(SRC_PATH)/tests/ref/fate/filter-pipeline-serial
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
@@ -453,6 +478,9 @@ fate-filter-null: CMD = video_filter "null"
 FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale200
 fate-filter-scale200: CMD = video_filter "scale=w=200:h=200"
 
+FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale200-threads
+fate-filter-scale200-threads: CMD = video_filter "scale=w=200:h=200" -filter_threads 4
+
 FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale500
 fate-filter-scale500: CMD = video_filter "scale=w=500:h=500"
 
@@ -738,6 +766,10 @@ FATE_METADATA_FILTER-$(call ALLYES, $(AVF_PHASE_METER_DEPS)) += fate-filter-meta
 fate-filter-metadata-avf-aphase-meter-out-of-phase: SRC = $(TARGET_SAMPLES)/filter/out-of-phase-1000hz.flac
 fate-filter-metadata-avf-aphase-meter-out-of-phase: CMD = run $(FILTER_METADATA_COMMAND) "amovie='$(SRC)',aphasemeter=video=0"
 
+MOTIONDETECT_METADATA_DEPS = AVDEVICE LAVFI_INDEV TESTSRC2_FILTER MOTIONDETECT_FILTER
+FATE_FFPROBE-$(call ALLYES, $(MOTIONDETECT_METADATA_DEPS)) += fate-filter-metadata-motiondetect
+fate-filter-metadata-motiondetect: CMD = run $(FILTER_METADATA_COMMAND) "testsrc2=s=320x240:r=10:d=2,motiondetect=zones=160x120+0+0|160x120+160+120"
+
 tests/data/file4560-override2rotate0.mov: TAG = GEN
 tests/data/file4560-override2rotate0.mov: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< \
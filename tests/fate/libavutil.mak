@@ -53,6 +53,11 @@ fate-cpu: libavutil/tests/cpu$(EXESUF)
 fate-cpu: CMD = runecho libavutil/tests/cpu $(CPUFLAGS:%=-c%) $(THREADS:%=-t%)
 fate-cpu: CMP = null
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-buffer_pool
+fate-buffer_pool: libavutil/tests/buffer_pool$(EXESUF)
+fate-buffer_pool: CMD = run libavutil/tests/buffer_pool
+fate-buffer_pool: CMP = null
+
 FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-cpu_init
 fate-cpu_init: libavutil/tests/cpu_init$(EXESUF)
 fate-cpu_init: CMD = run libavutil/tests/cpu_init
@@ -99,10 +104,18 @@ FATE_LIBAVUTIL += fate-lfg
 fate-lfg: libavutil/tests/lfg$(EXESUF)
 fate-lfg: CMD = run libavutil/tests/lfg
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-log
+fate-log: libavutil/tests/log$(EXESUF)
+fate-log: CMD = run libavutil/tests/log
+
 FATE_LIBAVUTIL += fate-md5
 fate-md5: libavutil/tests/md5$(EXESUF)
 fate-md5: CMD = run libavutil/tests/md5
 
+FATE_LIBAVUTIL += fate-mem_account
+fate-mem_account: libavutil/tests/mem_account$(EXESUF)
+fate-mem_account: CMD = run libavutil/tests/mem_account
+
 FATE_LIBAVUTIL += fate-murmur3
 fate-murmur3: libavutil/tests/murmur3$(EXESUF)
 fate-murmur3: CMD = run libavutil/tests/murmur3
@@ -1094,5 +1094,18 @@ fate-swr-audioconvert: CMP = stddev
 fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
+
+# low_delay round trip through an integer upsampling ratio
+FATE_SWR_LOW_DELAY-$(call FILTERDEMDECENCMUX, ARESAMPLE ATRIM, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-swr-low_delay
+fate-swr-low_delay: tests/data/asynth-8000-1.wav
+fate-swr-low_delay: CMD = ffmpeg -i $(TARGET_PATH)/tests/data/asynth-8000-1.wav -af atrim=end_sample=10240,aresample=48000:low_delay=1,aresample=8000 -f wav -c:a pcm_s16le -
+fate-swr-low_delay: CMP = stddev
+fate-swr-low_delay: CMP_UNIT = s16
+fate-swr-low_delay: FUZZ = 0.1
+fate-swr-low_delay: REF = tests/data/asynth-8000-1.wav
+fate-swr-low_delay: CMP_TARGET = 14.56
+fate-swr-low_delay: SIZE_TOLERANCE = 96000 - 20480
+
+FATE_SWR += $(FATE_SWR_LOW_DELAY-yes)
 FATE_FFMPEG += $(FATE_SWR)
 fate-swr: $(FATE_SWR)
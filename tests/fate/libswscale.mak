@@ -2,6 +2,10 @@ FATE_LIBSWSCALE += fate-sws-pixdesc-query
 fate-sws-pixdesc-query: libswscale/tests/pixdesc_query$(EXESUF)
 fate-sws-pixdesc-query: CMD = run libswscale/tests/pixdesc_query
 
+FATE_LIBSWSCALE += fate-sws-scale-frame
+fate-sws-scale-frame: libswscale/tests/scale_frame$(EXESUF)
+fate-sws-scale-frame: CMD = run libswscale/tests/scale_frame
+
 FATE_LIBSWSCALE += $(FATE_LIBSWSCALE-yes)
 FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
 fate-libswscale: $(FATE_LIBSWSCALE)
@@ -9,5 +9,19 @@ fate-matroska-remux: REF = 1ed49a4f2b6790357fac268938357353
 FATE_MATROSKA_FFPROBE-$(call ALLYES, MATROSKA_DEMUXER) += fate-matroska-spherical-mono
 fate-matroska-spherical-mono: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -show_entries stream_side_data_list -select_streams v -v 0 $(TARGET_SAMPLES)/mkv/spherical.mkv
 
+# This tests that only the first keyframe of each interval is read in
+# thumbnail mode, with the demuxer skipping the non-keyframe blocks.
+tests/data/keyframes.mkv: TAG = GEN
+tests/data/keyframes.mkv: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i testsrc=size=160x120:rate=25:duration=6 \
+        -c:v mpeg4 -g 25 -flags +bitexact -fflags +bitexact \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_MATROSKA_GEN_FFPROBE-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER MPEG4_ENCODER MATROSKA_MUXER MATROSKA_DEMUXER MPEG4_DECODER) += fate-matroska-keyframes-only
+fate-matroska-keyframes-only: tests/data/keyframes.mkv
+fate-matroska-keyframes-only: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -thumbnails_per_hour 1800 -show_entries packet=pts_time,flags:frame=pkt_pts_time,key_frame -of compact -bitexact -v 0 $(TARGET_PATH)/tests/data/keyframes.mkv
+
+FATE_FFPROBE += $(FATE_MATROSKA_GEN_FFPROBE-yes)
 FATE_SAMPLES_AVCONV += $(FATE_MATROSKA-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_MATROSKA_FFPROBE-yes)
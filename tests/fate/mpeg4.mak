@@ -17,3 +17,18 @@ fate-m4v-cfr: CMD = framecrc -flags +bitexact -idct simple -i $(TARGET_SAMPLES)/
 
 FATE_SAMPLES_AVCONV += $(FATE_MPEG4-yes)
 fate-mpeg4: $(FATE_MPEG4-yes)
+
+tests/data/mpeg4-bframes.nut: TAG = GEN
+tests/data/mpeg4-bframes.nut: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i testsrc=size=160x120:rate=25:duration=2 \
+        -c:v mpeg4 -bf 2 -g 12 -flags +bitexact -fflags +bitexact \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# A deadline of 1 us is always missed, so the decoder skips the loop filter
+# after 8 packets, the B-frames after 16 and all but keyframes after 24.
+FATE_MPEG4_FFMPEG-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER MPEG4_ENCODER NUT_MUXER NUT_DEMUXER MPEG4_DECODER FRAMECRC_MUXER) += fate-mpeg4-decode-deadline
+fate-mpeg4-decode-deadline: tests/data/mpeg4-bframes.nut
+fate-mpeg4-decode-deadline: CMD = run ffmpeg$(PROGSSUF)$(EXESUF) -nostdin -threads 1 -decode_deadline 1 -i $(TARGET_PATH)/tests/data/mpeg4-bframes.nut -flags +bitexact -fflags +bitexact -f framecrc -
+
+FATE_FFMPEG += $(FATE_MPEG4_FFMPEG-yes)